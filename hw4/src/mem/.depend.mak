@@ -1,4 +1,7 @@
-memTest.o: memTest.cpp memTest.h memMgr.h
+memTrace.o: memTrace.cpp memTrace.h
+memBench.o: memBench.cpp memBench.h memMgr.h memTrace.h \
+ ../../include/myUsage.h
+memTest.o: memTest.cpp memTest.h memMgr.h memTrace.h
 memCmd.o: memCmd.cpp memCmd.h ../../include/cmdParser.h \
- ../../include/cmdCharDef.h memTest.h memMgr.h ../../include/util.h \
- ../../include/rnGen.h ../../include/myUsage.h
+ ../../include/cmdCharDef.h memTest.h memMgr.h memTrace.h memBench.h \
+ ../../include/util.h ../../include/rnGen.h ../../include/myUsage.h
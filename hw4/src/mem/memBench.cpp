@@ -0,0 +1,300 @@
+/****************************************************************************
+  FileName     [ memBench.cpp ]
+  PackageName  [ mem ]
+  Synopsis     [ Define allocation benchmark of memory manager ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2007-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <cstring>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/ioctl.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif // __linux__
+#include "memBench.h"
+#include "memMgr.h"
+#include "myUsage.h"
+
+using namespace std;
+
+//----------------------------------------------------------------------
+//    Benchmark objects; all of the same layout as MemTestObj
+//----------------------------------------------------------------------
+class BenchObj
+{
+public:
+   BenchObj() : _key(0) { for (int i = 0; i < 10; ++i) _data[i] = i; }
+   virtual ~BenchObj() {}
+
+private:
+   size_t   _key;
+   int      _data[10];
+};
+
+class BenchObjMgr : public BenchObj
+{
+   USE_MEM_MGR(BenchObjMgr);
+};
+
+class BenchObjMalloc : public BenchObj
+{
+};
+
+#define BENCH_POOL_CHUNK 65536
+
+// Plain free-list pool in malloc'ed chunks: objects of one size, and
+// arrays in one free list per size (rounded up to SIZE_T Bytes), with a
+// SIZE_T header that keeps the size
+class BenchPool
+{
+public:
+   BenchPool(size_t s) : _objSize(toSizeT(s)), _free(0), _ptr(0), _end(0) {}
+   ~BenchPool() { for (size_t i = 0; i < _chunks.size(); ++i) ::free(_chunks[i]); }
+
+   void* alloc() {
+      if (_free) { void* p = _free; _free = *(void**)p; return p; }
+      return carve(_objSize);
+   }
+   void free(void* p) { *(void**)p = _free; _free = p; }
+   void* allocArr(size_t t) {
+      size_t c = toSizeT(t) / SIZE_T + 1;
+      if (c >= _arrFree.size()) _arrFree.resize(c + 1, 0);
+      size_t* p = (size_t*)_arrFree[c];
+      if (p) _arrFree[c] = *(void**)p;
+      else p = (size_t*)carve(c * SIZE_T);
+      *p = c;
+      return p + 1;
+   }
+   void freeArr(void* q) {
+      size_t* p = (size_t*)q - 1, c = *p;
+      *(void**)p = _arrFree[c];
+      _arrFree[c] = p;
+   }
+
+private:
+   size_t            _objSize;
+   void*             _free;
+   vector<void*>     _arrFree;
+   char*             _ptr;
+   char*             _end;
+   vector<char*>     _chunks;
+
+   // 'n' Bytes from the current chunk, or from a new one
+   void* carve(size_t n) {
+      if (size_t(_end - _ptr) < n) {
+         size_t s = n > BENCH_POOL_CHUNK? n: BENCH_POOL_CHUNK;
+         _ptr = (char*)malloc(s);
+         if (!_ptr) throw bad_alloc();
+         _chunks.push_back(_ptr);
+         _end = _ptr + s;
+      }
+      void* p = _ptr; _ptr += n;
+      return p;
+   }
+};
+
+class BenchObjPool : public BenchObj
+{
+public:
+   void* operator new(size_t t) { return _pool.alloc(); }
+   void* operator new[](size_t t) { return _pool.allocArr(t); }
+   void  operator delete(void* p) { _pool.free(p); }
+   void  operator delete[](void* p) { _pool.freeArr(p); }
+
+private:
+   static BenchPool _pool;
+};
+
+MEM_MGR_INIT(BenchObjMgr);
+BenchPool BenchObjPool::_pool(sizeof(BenchObjPool));
+
+static const char* benchPatternStr[MEM_BENCH_PATTERN_TOT] = {
+   "LIFO", "FIFO", "Random", "MixedArr", "ProdCons"
+};
+
+static const char* benchAllocStr[MEM_BENCH_ALLOC_TOT] = {
+   "MemMgr", "malloc", "Pool"
+};
+
+static inline size_t
+benchRand(size_t& x)
+{
+   x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+   return x;
+}
+
+// Return the #new + #delete
+template <class T>
+static size_t
+replayPattern(MemBenchPattern p, size_t n, size_t r)
+{
+   vector<T*> objs(n);
+   size_t x = 88172645463325252ull, ops = 0;
+   for (size_t k = 0; k < r; ++k) {
+      switch (p) {
+         case MEM_BENCH_LIFO:
+            for (size_t i = 0; i < n; ++i) objs[i] = new T;
+            for (size_t i = n; i > 0; --i) delete objs[i - 1];
+            ops += 2 * n;
+            break;
+         case MEM_BENCH_FIFO:
+            for (size_t i = 0; i < n; ++i) objs[i] = new T;
+            for (size_t i = 0; i < n; ++i) delete objs[i];
+            ops += 2 * n;
+            break;
+         case MEM_BENCH_RANDOM:
+            for (size_t i = 0; i < n; ++i) objs[i] = new T;
+            for (size_t i = n; i > 0; --i) {
+               size_t j = benchRand(x) % i;
+               delete objs[j];
+               objs[j] = objs[i - 1];
+            }
+            ops += 2 * n;
+            break;
+         case MEM_BENCH_MIXED_ARR:
+            for (size_t i = 0; i < n; ++i)
+               objs[i] = new T[1 + benchRand(x) % 64];
+            for (size_t i = 0; i < n; ++i) {
+               size_t j = benchRand(x) % n;
+               delete[] objs[j];
+               objs[j] = new T[1 + benchRand(x) % 64];
+            }
+            for (size_t i = 0; i < n; ++i) delete[] objs[i];
+            ops += 4 * n;
+            break;
+         case MEM_BENCH_PROD_CONS: {
+            // The producer is slightly faster, so the queue grows to n
+            size_t head = 0, size = 0;
+            for (size_t produced = 0; produced < n; ) {
+               for (size_t b = 1 + benchRand(x) % 16;
+                    b && size < n && produced < n; --b, ++produced, ++size)
+                  objs[(head + size) % n] = new T;
+               for (size_t b = 1 + benchRand(x) % 12; b && size; --b, --size) {
+                  delete objs[head];
+                  if (++head == n) head = 0;
+               }
+            }
+            for (; size; --size) {
+               delete objs[head];
+               if (++head == n) head = 0;
+            }
+            ops += 2 * n;
+            break;
+         }
+         default: break;
+      }
+   }
+   return ops;
+}
+
+size_t
+MemBench::replay(MemBenchPattern p, MemBenchAlloc a) const
+{
+   switch (a) {
+      case MEM_BENCH_MEM_MGR:
+         return replayPattern<BenchObjMgr>(p, _numObjs, _numRounds);
+      case MEM_BENCH_MALLOC:
+         return replayPattern<BenchObjMalloc>(p, _numObjs, _numRounds);
+      case MEM_BENCH_POOL:
+         return replayPattern<BenchObjPool>(p, _numObjs, _numRounds);
+      default: return 0;
+   }
+}
+
+// Return the fd of the cache-miss counter of this process; -1 if N/A
+static int
+openCacheMissCounter()
+{
+#ifdef __linux__
+   perf_event_attr pe;
+   memset(&pe, 0, sizeof(pe));
+   pe.type = PERF_TYPE_HARDWARE;
+   pe.size = sizeof(pe);
+   pe.config = PERF_COUNT_HW_CACHE_MISSES;
+   pe.disabled = 1;
+   pe.exclude_kernel = 1;
+   pe.exclude_hv = 1;
+   return syscall(__NR_perf_event_open, &pe, 0, -1, -1, 0);
+#else
+   return -1;
+#endif // __linux__
+}
+
+bool
+MemBench::run(MemBenchPattern p, MemBenchAlloc a, MemBenchResult& res) const
+{
+   int fd[2];
+   if (pipe(fd) != 0) return false;
+   pid_t pid = fork();
+   if (pid < 0) { close(fd[0]); close(fd[1]); return false; }
+   if (pid == 0) {
+      close(fd[0]);
+      MyUsage usage;
+      MemBenchResult r;
+      r._cacheMisses = -1;
+      int pfd = openCacheMissCounter();
+      try {
+         #ifdef __linux__
+         if (pfd >= 0) {
+            ioctl(pfd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(pfd, PERF_EVENT_IOC_ENABLE, 0);
+         }
+         #endif // __linux__
+         chrono::steady_clock::time_point start = chrono::steady_clock::now();
+         r._numOps = replay(p, a);
+         chrono::duration<double, nano> d = chrono::steady_clock::now() - start;
+         #ifdef __linux__
+         if (pfd >= 0) {
+            ioctl(pfd, PERF_EVENT_IOC_DISABLE, 0);
+            long long c;
+            if (read(pfd, &c, sizeof(c)) == sizeof(c)) r._cacheMisses = c;
+         }
+         #endif // __linux__
+         r._nsPerOp = r._numOps? d.count() / r._numOps: 0;
+      } catch (const bad_alloc&) { _exit(1); }
+      r._peakMem = usage.getPeakMem();
+      ssize_t w = write(fd[1], &r, sizeof(r));
+      _exit(w == sizeof(r)? 0: 1);
+   }
+   close(fd[1]);
+   bool ok = (read(fd[0], &res, sizeof(res)) == sizeof(res));
+   close(fd[0]);
+   int status;
+   if (waitpid(pid, &status, 0) != pid) return false;
+   return ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+void
+MemBench::report(ostream& os) const
+{
+   ios_base::fmtflags f = os.flags();
+   streamsize prec = os.precision();
+   os << "Objects: " << _numObjs << " (" << sizeof(BenchObj)
+      << " Bytes), rounds: " << _numRounds << endl
+      << setw(10) << left << "Pattern" << setw(8) << "Alloc"
+      << setw(10) << right << "ns/op" << setw(16) << "Peak RSS (MB)"
+      << setw(16) << "Cache misses" << endl;
+   os << fixed;
+   for (int p = 0; p < MEM_BENCH_PATTERN_TOT; ++p)
+      for (int a = 0; a < MEM_BENCH_ALLOC_TOT; ++a) {
+         MemBenchResult res;
+         os << setw(10) << left << benchPatternStr[p]
+            << setw(8) << benchAllocStr[a] << right;
+         if (!run(MemBenchPattern(p), MemBenchAlloc(a), res)) {
+            os << setw(10) << "failed" << endl;
+            continue;
+         }
+         os << setw(10) << setprecision(2) << res._nsPerOp
+            << setw(16) << setprecision(1) << res._peakMem << setw(16);
+         if (res._cacheMisses < 0) os << "N/A";
+         else os << res._cacheMisses;
+         os << endl;
+      }
+   os.flags(f);
+   os.precision(prec);
+}
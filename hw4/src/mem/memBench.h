@@ -0,0 +1,72 @@
+/****************************************************************************
+  FileName     [ memBench.h ]
+  PackageName  [ mem ]
+  Synopsis     [ Define allocation benchmark of memory manager ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2007-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#ifndef MEM_BENCH_H
+#define MEM_BENCH_H
+
+#include <iostream>
+
+using namespace std;
+
+//----------------------------------------------------------------------
+//    Allocation benchmark
+//----------------------------------------------------------------------
+// Replay synthetic new/delete patterns on objects of the same layout
+// managed by MemMgr, by glibc malloc (the default new/delete), and by
+// a plain free-list pool (one free list per object or array size).
+// Each run is forked into a child process so that its peak RSS is not
+// polluted by the other runs.
+//
+enum MemBenchPattern
+{
+   MEM_BENCH_LIFO,       // allocate n, delete in reverse order
+   MEM_BENCH_FIFO,       // allocate n, delete in allocation order
+   MEM_BENCH_RANDOM,     // allocate n, delete in random order
+   MEM_BENCH_MIXED_ARR,  // n arrays of size 1..64, replaced at random
+   MEM_BENCH_PROD_CONS,  // queue of random produce/consume bursts
+
+   MEM_BENCH_PATTERN_TOT
+};
+
+enum MemBenchAlloc
+{
+   MEM_BENCH_MEM_MGR,
+   MEM_BENCH_MALLOC,
+   MEM_BENCH_POOL,
+
+   MEM_BENCH_ALLOC_TOT
+};
+
+struct MemBenchResult
+{
+   size_t      _numOps;       // #new + #delete
+   double      _nsPerOp;
+   double      _peakMem;      // peak RSS in MB
+   long long   _cacheMisses;  // -1 if perf counters are not available
+};
+
+class MemBench
+{
+public:
+   // 'n' objects, repeated for 'r' rounds
+   MemBench(size_t n, size_t r) : _numObjs(n), _numRounds(r) {}
+   ~MemBench() {}
+
+   // Run 'p' on 'a'; return false if the run failed
+   bool run(MemBenchPattern p, MemBenchAlloc a, MemBenchResult& res) const;
+   // Run all the patterns on all the allocators and print a table
+   void report(ostream& os) const;
+
+private:
+   size_t      _numObjs;
+   size_t      _numRounds;
+
+   size_t replay(MemBenchPattern p, MemBenchAlloc a) const;
+};
+
+#endif // MEM_BENCH_H
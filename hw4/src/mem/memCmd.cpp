@@ -7,8 +7,10 @@
 ****************************************************************************/
 #include <iostream>
 #include <iomanip>
+#include <thread>
 #include "memCmd.h"
 #include "memTest.h"
+#include "memBench.h"
 #include "cmdParser.h"
 #include "util.h"
 
@@ -22,7 +24,11 @@ initMemCmd()
    if (!(cmdMgr->regCmd("MTReset", 3, new MTResetCmd) &&
          cmdMgr->regCmd("MTNew", 3, new MTNewCmd) &&
          cmdMgr->regCmd("MTDelete", 3, new MTDeleteCmd) &&
-         cmdMgr->regCmd("MTPrint", 3, new MTPrintCmd)
+         cmdMgr->regCmd("MTPrint", 3, new MTPrintCmd) &&
+         cmdMgr->regCmd("MTStress", 3, new MTStressCmd) &&
+         cmdMgr->regCmd("MTCompact", 3, new MTCompactCmd) &&
+         cmdMgr->regCmd("MTTrace", 3, new MTTraceCmd) &&
+         cmdMgr->regCmd("MTBench", 3, new MTBenchCmd)
       )) {
       cerr << "Registering \"mem\" commands fails... exiting" << endl;
       return false;
@@ -32,36 +38,54 @@ initMemCmd()
 
 
 //----------------------------------------------------------------------
-//    MTReset [(size_t blockSize)]
+//    MTReset [(size_t blockSize)] [-SizeClass | -Exact]
 //----------------------------------------------------------------------
 CmdExecStatus
 MTResetCmd::exec(const string& option)
 {
    // check option
-   string token;
-   if (!CmdExec::lexSingleOption(option, token))
+   vector<string> options;
+   if (!CmdExec::lexOptions(option, options))
       return CMD_EXEC_ERROR;
-   if (token.size()) {
-      int b;
-      if (!myStr2Int(token, b) || b < int(toSizeT(sizeof(MemTestObj)))) {
-         cerr << "Illegal block size (" << token << ")!!" << endl;
-         return CmdExec::errorOption(CMD_OPT_ILLEGAL, token);
+
+   string token;
+   int mode = -1;  // -1: unchanged; 0: exact; 1: size class
+   for (size_t i = 0, n = options.size(); i < n; ++i) {
+      if (myStrNCmp("-SizeClass", options[i], 2) == 0 ||
+          myStrNCmp("-Exact", options[i], 2) == 0) {
+         if (mode != -1)
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         mode = (myStrNCmp("-SizeClass", options[i], 2) == 0)? 1: 0;
       }
-      #ifdef MEM_MGR_H
-      mtest.reset(toSizeT(b));
-      #else
-      mtest.reset();
-      #endif // MEM_MGR_H
+      else if (token.size())
+         return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+      else
+         token = options[i];
    }
+   // Check all the arguments before changing the manager
+   int b = 0;
+   if (token.size() &&
+       (!myStr2Int(token, b) || b < int(toSizeT(sizeof(MemTestObj))))) {
+      cerr << "Illegal block size (" << token << ")!!" << endl;
+      return CmdExec::errorOption(CMD_OPT_ILLEGAL, token);
+   }
+   #ifdef MEM_MGR_H
+   if (mode != -1)
+      MemTestObj::memSetSizeClass(mode == 1);
+   if (token.size())
+      mtest.reset(toSizeT(b));
    else
       mtest.reset();
+   #else
+   mtest.reset();
+   #endif // MEM_MGR_H
    return CMD_EXEC_DONE;
 }
 
 void
 MTResetCmd::usage(ostream& os) const
 {  
-   os << "Usage: MTReset [(size_t blockSize)]" << endl;
+   os << "Usage: MTReset [(size_t blockSize)] [-SizeClass | -Exact]" << endl;
 }
 
 void
@@ -277,15 +301,21 @@ MTDeleteCmd::help() const
 
 
 //----------------------------------------------------------------------
-//    MTPrint
+//    MTPrint [-Stats]
 //----------------------------------------------------------------------
 CmdExecStatus
 MTPrintCmd::exec(const string& option)
 {
    // check option
-   if (option.size())
-      return CmdExec::errorOption(CMD_OPT_EXTRA, option);
-   mtest.print();
+   string token;
+   if (!CmdExec::lexSingleOption(option, token))
+      return CMD_EXEC_ERROR;
+   if (token.empty())
+      mtest.print();
+   else if (myStrNCmp("-Stats", token, 2) == 0)
+      mtest.printStats();
+   else
+      return CmdExec::errorOption(CMD_OPT_ILLEGAL, token);
 
    return CMD_EXEC_DONE;
 }
@@ -293,7 +323,7 @@ MTPrintCmd::exec(const string& option)
 void
 MTPrintCmd::usage(ostream& os) const
 {  
-   os << "Usage: MTPrint" << endl;
+   os << "Usage: MTPrint [-Stats]" << endl;
 }
 
 void
@@ -304,3 +334,245 @@ MTPrintCmd::help() const
 }
 
 
+
+
+//----------------------------------------------------------------------
+//    MTStress <(size_t numObjects)> [-Array (size_t arraySize)]
+//             [-Thread (size_t maxThreads)]
+//----------------------------------------------------------------------
+CmdExecStatus
+MTStressCmd::exec(const string& option)
+{
+   vector<string> options;
+   if (!CmdExec::lexOptions(option, options))
+      return CMD_EXEC_ERROR;
+   if (options.empty())
+      return CmdExec::errorOption(CMD_OPT_MISSING, "");
+
+   size_t numObjects = 0, arraySize = 0, maxThreads = 0;
+   for (size_t i = 0, n = options.size(); i < n; ++i) {
+      size_t* target = &numObjects;
+      if (myStrNCmp("-Array", options[i], 2) == 0)
+         target = &arraySize;
+      else if (myStrNCmp("-Thread", options[i], 2) == 0)
+         target = &maxThreads;
+      else --i;
+      if (*target)
+         return CmdExec::errorOption(CMD_OPT_EXTRA, options[i + 1]);
+      if (++i >= n)
+         return CmdExec::errorOption(CMD_OPT_MISSING, options[i - 1]);
+      int num;
+      if (!myStr2Int(options[i], num) || num <= 0)
+         return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+      *target = size_t(num);
+   }
+   if (numObjects == 0)
+      return CmdExec::errorOption(CMD_OPT_MISSING, "");
+   if (maxThreads == 0) {
+      maxThreads = thread::hardware_concurrency();
+      if (maxThreads == 0) maxThreads = 1;
+   }
+
+   streamsize prec = cout.precision();
+   cout << setw(8) << right << "Threads" << setw(14) << "Allocs"
+        << setw(12) << "Time(s)" << setw(16) << "Allocs/sec" << endl;
+   try {
+      for (size_t t = 1; ; t = (t * 2 > maxThreads && t < maxThreads)?
+                                maxThreads: t * 2) {
+         size_t nAlloc;
+         double sec = mtest.stress(t, numObjects, arraySize, nAlloc);
+         cout << setw(8) << t << setw(14) << nAlloc << setw(12) << fixed
+              << setprecision(4) << sec << setw(16) << setprecision(0)
+              << (sec > 0? nAlloc / sec: 0) << endl;
+         cout.unsetf(ios::fixed);
+         cout.precision(prec);
+         if (t >= maxThreads) break;
+      }
+   } catch (const bad_alloc&) { cout.precision(prec); return CMD_EXEC_ERROR; }
+
+   return CMD_EXEC_DONE;
+}
+
+void
+MTStressCmd::usage(ostream& os) const
+{
+   os << "Usage: MTStress <(size_t numObjects)> [-Array (size_t arraySize)] "
+      << "[-Thread (size_t maxThreads)]" << endl;
+}
+
+void
+MTStressCmd::help() const
+{
+   cout << setw(15) << left << "MTStress: "
+        << "(memory test) multi-threaded new/delete stress test" << endl;
+}
+
+
+//----------------------------------------------------------------------
+//    MTCompact [-Threshold (size_t numBlocks)]
+//----------------------------------------------------------------------
+CmdExecStatus
+MTCompactCmd::exec(const string& option)
+{
+   vector<string> options;
+   if (!CmdExec::lexOptions(option, options))
+      return CMD_EXEC_ERROR;
+
+   if (options.empty()) {
+      cout << "Memory returned to the OS: " << mtest.compact() << " Bytes"
+           << endl;
+      return CMD_EXEC_DONE;
+   }
+   if (myStrNCmp("-Threshold", options[0], 2) != 0)
+      return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[0]);
+   if (options.size() == 1)
+      return CmdExec::errorOption(CMD_OPT_MISSING, options[0]);
+   if (options.size() > 2)
+      return CmdExec::errorOption(CMD_OPT_EXTRA, options[2]);
+   int n;
+   if (!myStr2Int(options[1], n) || n < 0)
+      return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[1]);
+   mtest.setReleaseThreshold(size_t(n));
+
+   return CMD_EXEC_DONE;
+}
+
+void
+MTCompactCmd::usage(ostream& os) const
+{
+   os << "Usage: MTCompact [-Threshold (size_t numBlocks)]" << endl;
+}
+
+void
+MTCompactCmd::help() const
+{
+   cout << setw(15) << left << "MTCompact: "
+        << "(memory test) coalesce and release recycled memory" << endl;
+}
+
+
+//----------------------------------------------------------------------
+//    MTTrace <-ON [(size_t bufSize)] | -OFf | -Dump (string traceFile)
+//             | -Summary (string traceFile)>
+//----------------------------------------------------------------------
+CmdExecStatus
+MTTraceCmd::exec(const string& option)
+{
+   vector<string> options;
+   if (!CmdExec::lexOptions(option, options))
+      return CMD_EXEC_ERROR;
+   if (options.empty())
+      return CmdExec::errorOption(CMD_OPT_MISSING, "");
+
+   MemTrace* trace = mtest.getTrace();
+   if (!trace) {
+      cerr << "Error: memory manager is not used!!" << endl;
+      return CMD_EXEC_ERROR;
+   }
+   const string& opt = options[0];
+   if (myStrNCmp("-ON", opt, 3) == 0) {
+      int n = 1 << 20;
+      if (options.size() > 2)
+         return CmdExec::errorOption(CMD_OPT_EXTRA, options[2]);
+      if (options.size() == 2 && (!myStr2Int(options[1], n) || n <= 0))
+         return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[1]);
+      trace->start(size_t(n));
+      cout << "Tracing memory events (buffer of " << n << " events)..."
+           << endl;
+      return CMD_EXEC_DONE;
+   }
+   if (myStrNCmp("-OFf", opt, 3) == 0) {
+      if (options.size() > 1)
+         return CmdExec::errorOption(CMD_OPT_EXTRA, options[1]);
+      trace->stop();
+      cout << "Memory events recorded: " << trace->getNumRecs() << endl;
+      return CMD_EXEC_DONE;
+   }
+   bool isDump = (myStrNCmp("-Dump", opt, 2) == 0);
+   if (!isDump && myStrNCmp("-Summary", opt, 2) != 0)
+      return CmdExec::errorOption(CMD_OPT_ILLEGAL, opt);
+   if (options.size() == 1)
+      return CmdExec::errorOption(CMD_OPT_MISSING, opt);
+   if (options.size() > 2)
+      return CmdExec::errorOption(CMD_OPT_EXTRA, options[2]);
+   if (isDump) {
+      if (!trace->dump(options[1])) {
+         cerr << "Error: cannot write file \"" << options[1] << "\"!!"
+              << endl;
+         return CMD_EXEC_ERROR;
+      }
+      cout << trace->getNumKept() << " events dumped to \"" << options[1]
+           << "\"" << endl;
+   }
+   else if (!MemTrace::summarize(options[1], cout)) {
+      cerr << "Error: \"" << options[1] << "\" is not a valid trace file!!"
+           << endl;
+      return CMD_EXEC_ERROR;
+   }
+
+   return CMD_EXEC_DONE;
+}
+
+void
+MTTraceCmd::usage(ostream& os) const
+{
+   os << "Usage: MTTrace <-ON [(size_t bufSize)] | -OFf | "
+      << "-Dump (string traceFile) | -Summary (string traceFile)>" << endl;
+}
+
+void
+MTTraceCmd::help() const
+{
+   cout << setw(15) << left << "MTTrace: "
+        << "(memory test) trace memory events at run time" << endl;
+}
+
+
+//----------------------------------------------------------------------
+//    MTBench [(size_t numObjects)] [-Rounds (size_t numRounds)]
+//----------------------------------------------------------------------
+CmdExecStatus
+MTBenchCmd::exec(const string& option)
+{
+   vector<string> options;
+   if (!CmdExec::lexOptions(option, options))
+      return CMD_EXEC_ERROR;
+
+   int numObjects = 100000, numRounds = 10;
+   bool hasNum = false, hasRounds = false;
+   for (size_t i = 0, n = options.size(); i < n; ++i) {
+      if (myStrNCmp("-Rounds", options[i], 2) == 0) {
+         if (hasRounds)
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i - 1]);
+         if (!myStr2Int(options[i], numRounds) || numRounds <= 0)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         hasRounds = true;
+      }
+      else if (!hasNum) {
+         if (!myStr2Int(options[i], numObjects) || numObjects <= 0)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         hasNum = true;
+      }
+      else return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+   }
+   cout.flush();
+   MemBench(size_t(numObjects), size_t(numRounds)).report(cout);
+
+   return CMD_EXEC_DONE;
+}
+
+void
+MTBenchCmd::usage(ostream& os) const
+{
+   os << "Usage: MTBench [(size_t numObjects)] [-Rounds (size_t numRounds)]"
+      << endl;
+}
+
+void
+MTBenchCmd::help() const
+{
+   cout << setw(15) << left << "MTBench: "
+        << "(memory test) benchmark MemMgr against malloc and a pool" << endl;
+}
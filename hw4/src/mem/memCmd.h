@@ -14,5 +14,9 @@ CmdClass(MTResetCmd);
 CmdClass(MTNewCmd);
 CmdClass(MTDeleteCmd);
 CmdClass(MTPrintCmd);
+CmdClass(MTStressCmd);
+CmdClass(MTCompactCmd);
+CmdClass(MTTraceCmd);
+CmdClass(MTBenchCmd);
 
 #endif // MEM_CMD_H
@@ -13,6 +13,13 @@
 #include <iostream>
 #include <iomanip>
 #include <stdlib.h>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <algorithm>
+#include "memTrace.h"
 
 using namespace std;
 
@@ -32,10 +39,32 @@ public:                                                                     \
    void  operator delete(void* p) { _memMgr->free((T*)p); }                 \
    void  operator delete[](void* p) { _memMgr->freeArr((T*)p); }            \
    static void memReset(size_t b = 0) { _memMgr->reset(b); }                \
+   static void memSetSizeClass(bool c) { _memMgr->setSizeClass(c); }       \
+   static size_t memCompact() {                                            \
+      _memMgr->coalesce(); return _memMgr->compact(); }                    \
+   static void memSetReleaseThreshold(size_t n)                            \
+      { _memMgr->setReleaseThreshold(n); }                                  \
    static void memPrint() { _memMgr->print(); }                             \
+   static void memPrintStats(ostream& os) { _memMgr->printStats(os); }      \
+   static MemTrace& memTrace() { return _memMgr->getTrace(); }              \
 private:                                                                    \
    static MemMgr<T>* const _memMgr
 
+// Thread-safe version; see class MemMgrMT
+#define MEM_MGR_MT_INIT(T) \
+MemMgrMT<T>* const T::_memMgr = new MemMgrMT<T>
+
+#define USE_MEM_MGR_MT(T)                                                   \
+public:                                                                     \
+   void* operator new(size_t t) { return (void*)(_memMgr->alloc(t)); }      \
+   void* operator new[](size_t t) { return (void*)(_memMgr->allocArr(t)); } \
+   void  operator delete(void* p) { _memMgr->free((T*)p); }                 \
+   void  operator delete[](void* p) { _memMgr->freeArr((T*)p); }            \
+   static void memReset(size_t b = 0) { _memMgr->reset(b); }                \
+   static void memPrint() { _memMgr->print(); }                             \
+private:                                                                    \
+   static MemMgrMT<T>* const _memMgr
+
 // You should use the following two MACROs whenever possible to 
 // make your code 64/32-bit platform independent.
 // DO NOT use 4 or 8 for sizeof(size_t) in your code
@@ -56,10 +85,27 @@ private:                                                                    \
 // R_SIZE is the size of the recycle list
 #define R_SIZE 256
 
+// Each MemBlock is mmap'ed at an address aligned to a power of 2, and
+// starts with a header (holding its MemBlock pointer) of MEM_BLOCK_HDR
+// Bytes. So the MemBlock of any recycled memory can be found in O(1).
+#define MEM_BLOCK_HDR   (2 * sizeof(size_t))
+
+// Default #fully-recycled MemBlocks that triggers MemMgr::compact()
+#define MEM_RELEASE_THRESHOLD 8
+
+// In size-class mode, array sizes >= R_SIZE are rounded up to geometric
+// size classes: R_CLASS_SUB classes per power of 2, starting from R_SIZE.
+// (e.g. 256, 320, 384, 448, 512, 640, ...)
+// R_CLASS is the number of such classes whose array size fits in a size_t.
+#define R_SIZE_LOG    8
+#define R_CLASS_SUB   4
+#define R_CLASS       ((sizeof(size_t) * 8 - R_SIZE_LOG - 1) * R_CLASS_SUB)
+
 //--------------------------------------------------------------------------
 // Forward declarations
 //--------------------------------------------------------------------------
 template <class T> class MemMgr;
+template <class T> class MemMgrMT;
 
 
 //--------------------------------------------------------------------------
@@ -76,12 +122,35 @@ class MemBlock
    friend class MemMgr<T>;
 
    // Constructor/Destructor
-   MemBlock(MemBlock<T>* n, size_t b) : _nextBlock(n) {
-      _begin = _ptr = new char[b]; _end = _begin + b; }
-   ~MemBlock() { delete [] _begin; }
+   // 'a' is the alignment (a power of 2, >= MEM_BLOCK_HDR + b)
+   MemBlock(MemBlock<T>* n, size_t b, size_t a) : _nextBlock(n), _numObjs(0) {
+      _size = MEM_BLOCK_HDR + b;
+      _base = mapAligned(_size, a);
+      *(MemBlock<T>**)_base = this;
+      _begin = _ptr = _base + MEM_BLOCK_HDR; _end = _begin + b; }
+   ~MemBlock() { munmap(_base, _size); }
 
    // Member functions
-   void reset() { _ptr = _begin; }
+   void reset() { _ptr = _begin; _numObjs = 0; }
+   // Get the MemBlock of the memory 'p' in a block aligned to 'a'
+   static MemBlock<T>* getMemBlock(const void* p, size_t a) {
+      return *(MemBlock<T>**)(size_t(p) & ~(a - 1)); }
+   // mmap 's' Bytes at an address aligned to 'a' (a power of 2) by
+   // mapping 's' + 'a' Bytes and unmapping the unaligned head and tail
+   static char* mapAligned(size_t s, size_t a) {
+      size_t pg = sysconf(_SC_PAGESIZE);
+      size_t m = (a > pg)? s + a: s;
+      void* p = mmap(0, m, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (p == MAP_FAILED) throw bad_alloc();
+      if (a <= pg) return (char*)p;
+      char* raw = (char*)p;
+      char* ret = (char*)((size_t(raw) + a - 1) & ~(a - 1));
+      char* tail = ret + (s + pg - 1) / pg * pg;
+      if (ret != raw) munmap(raw, ret - raw);
+      if (tail < raw + m) munmap(tail, raw + m - tail);
+      return ret;
+   }
    // 1. Get (at least) 't' bytes memory from current block
    //    Promote 't' to a multiple of SIZE_T
    // 2. Update "_ptr" accordingly
@@ -97,14 +166,22 @@ class MemBlock
       return true;
    }
    size_t getRemainSize() const { return size_t(_end - _ptr); }
+   // #Bytes of the pages mmap'ed
+   size_t getMappedSize() const {
+      size_t pg = sysconf(_SC_PAGESIZE);
+      return (_size + pg - 1) / pg * pg;
+   }
       
    MemBlock<T>* getNextBlock() const { return _nextBlock; }
 
    // Data members
+   char*             _base;      // the mmap'ed address
+   size_t            _size;      // #Bytes mmap'ed
    char*             _begin;
    char*             _ptr;
    char*             _end;
    MemBlock<T>*      _nextBlock;
+   size_t            _numObjs;   // #objects/arrays not recycled
 };
 
 // Make it a private class;
@@ -116,7 +193,8 @@ class MemRecycleList
    friend class MemMgr<T>;
 
    // Constructor/Destructor
-   MemRecycleList(size_t a = 0) : _arrSize(a), _first(0), _nextList(0) {}
+   MemRecycleList(size_t a = 0)
+   : _arrSize(a), _first(0), _numElm(0), _nextList(0) {}
    ~MemRecycleList() { reset(); }
 
    // Member functions
@@ -128,7 +206,7 @@ class MemRecycleList
    T* popFront() {
       // TODO
       T* tmp = _first;
-      if(_first)_first = (T*)*(size_t**)_first;
+      if(_first) { _first = (T*)*(size_t**)_first; --_numElm; }
       else _first = 0;
       return tmp;
    }
@@ -138,6 +216,13 @@ class MemRecycleList
       size_t** address = (size_t**)p;
       *address = (size_t*)_first;
       _first = p;
+      ++_numElm;
+   }
+   // push the chain of 'k' elements 'first' ... 'last' to the beginning
+   void  pushFront(T* first, T* last, size_t k) {
+      *(T**)last = _first;
+      _first = first;
+      _numElm += k;
    }
    // Release the memory occupied by the recycle list(s)
    // DO NOT release the memory occupied by MemMgr/MemBlock
@@ -150,41 +235,70 @@ class MemRecycleList
          _nextList = 0;
       }
       _first = 0;
+      _numElm = 0;
    }
 
    // Helper functions
    // ----------------
-   // count the number of elements in the recycle list
-   size_t numElm() const {
-      // TODO
-      size_t cnt = 0;
-      T* tmp = _first;
-      while(tmp)
-      {
-         cnt++;
-         tmp = (T*)*(size_t**)tmp;
-      }
-      return cnt;
-   }
+   // the number of elements in the recycle list
+   size_t numElm() const { return _numElm; }
 
    // Data members
    size_t              _arrSize;   // the array size of the recycled data
    T*                  _first;     // the first recycled data
+   size_t              _numElm;    // #elements in the list
    MemRecycleList<T>*  _nextList;  // next MemRecycleList
                                    //      with _arrSize + x*R_SIZE
 };
 
+// Make it a private class;
+// Only friend to MemMgr;
+//
+// Memory larger than the block size is mmap'ed separately, headed by
+// a MemLargeObj which links it into the circular list MemMgr::_largeList.
+//
+template <class T>
+class MemLargeObj
+{
+   friend class MemMgr<T>;
+
+   // Constructor for the list head
+   MemLargeObj() : _prev(this), _next(this), _size(0) {}
+
+   // Member functions
+   static MemLargeObj<T>* getLargeObj(T* p) { return (MemLargeObj<T>*)p - 1; }
+   T* getMem() { return (T*)(this + 1); }
+   void insertAfter(MemLargeObj<T>* l) {
+      _prev = l; _next = l->_next; _next->_prev = this; l->_next = this; }
+   void remove() { _prev->_next = _next; _next->_prev = _prev; }
+
+   // Data members
+   MemLargeObj<T>*   _prev;
+   MemLargeObj<T>*   _next;
+   size_t            _size;    // #Bytes mmap'ed, including this header
+   size_t            _dummy;   // keep the returned memory 16-byte aligned
+};
+
 template <class T>
 class MemMgr
 {
    #define S sizeof(T)
 
 public:
-   MemMgr(size_t b = 65536) : _blockSize(b) {
+   MemMgr(size_t b = 65536, bool c = false)
+   : _blockSize(b), _sizeClass(c), _numLarge(0), _largeSize(0),
+     _numFreeBlocks(1), _releaseThreshold(MEM_RELEASE_THRESHOLD),
+     _numBlocks(1), _maxNumBlocks(1), _inUseSize(0), _maxInUseSize(0),
+     _recycledSize(0), _numAllocs(0), _numFrees(0), _coalesceSize(0),
+     _compactSize(0) {
       assert(b % SIZE_T == 0);
-      _activeBlock = new MemBlock<T>(0, _blockSize);
+      _blockAlign = getBlockAlign(_blockSize);
+      _activeBlock = new MemBlock<T>(0, _blockSize, _blockAlign);
       for (int i = 0; i < R_SIZE; ++i)
          _recycleList[i]._arrSize = i;
+      for (size_t i = 0; i < R_CLASS; ++i)
+         _classList[i]._arrSize = getClassArrSize(i);
+      clearNonEmpty();
    }
    ~MemMgr() { reset(); delete _activeBlock; }
 
@@ -203,6 +317,10 @@ public:
       // TODO
       for(size_t i = 0; i < R_SIZE; ++i)
          _recycleList[i].reset();
+      for(size_t i = 0; i < R_CLASS; ++i)
+         _classList[i].reset();
+      while (_largeList._next != &_largeList)
+         freeLargeMem(_largeList._next->getMem());
       MemBlock<T>* tmp = _activeBlock;
       _activeBlock = tmp->getNextBlock();
       while(_activeBlock)
@@ -216,10 +334,118 @@ public:
       {
          delete tmp;
          _blockSize = b;
-         tmp = new MemBlock<T>(0,_blockSize);
+         _blockAlign = getBlockAlign(_blockSize);
+         tmp = new MemBlock<T>(0,_blockSize,_blockAlign);
       }
       _activeBlock = tmp;
+      _numFreeBlocks = 1;
+      _numBlocks = _maxNumBlocks = 1;
+      _inUseSize = _maxInUseSize = _recycledSize = 0;
+      _numAllocs = _numFrees = 0;
+      _coalesceSize = _compactSize = 0;
+      clearNonEmpty();
+   }
+   // Release the MemBlocks whose objects have all been recycled
+   // (except the active one) and remove their memory from the recycle
+   // lists. Return the #Bytes returned to the OS.
+   // Called automatically when the #such MemBlocks reaches
+   // _releaseThreshold (0: never).
+   size_t compact() {
+      #ifdef MEM_DEBUG
+      cout << "Compacting memMgr..." << endl;
+      #endif // MEM_DEBUG
+      _compactSize = 0;
+      if (getNumReleasable() == 0)
+         return 0;
+      for (size_t i = 0; i < R_SIZE; ++i)
+         for (MemRecycleList<T>* l = &_recycleList[i]; l; l = l->_nextList)
+            compactRecycleList(l);
+      for (size_t i = 0; i < R_CLASS; ++i)
+         compactRecycleList(&_classList[i]);
+      size_t ret = 0;
+      MemBlock<T>** pb = &(_activeBlock->_nextBlock);
+      while (*pb) {
+         MemBlock<T>* b = *pb;
+         if (b->_numObjs == 0) {
+            #ifdef MEM_DEBUG
+            cout << "Releasing MemBlock... " << b << endl;
+            #endif // MEM_DEBUG
+            *pb = b->_nextBlock;
+            ret += b->getMappedSize();
+            --_numFreeBlocks; --_numBlocks;
+            delete b;
+         }
+         else pb = &(b->_nextBlock);
+      }
+      return ret;
    }
+   // Merge the adjacent recycled memory in each MemBlock, and re-recycle
+   // the merged memory to the largest possible array sizes. Memory that
+   // ends at the free space of the active block is returned to it.
+   // Called by getMem() before a new MemBlock is allocated, if the
+   // memory recycled since the last call is at least _blockSize Bytes
+   // and no less than all the recycled memory (so its cost is amortized).
+   // Return the #pieces of memory merged away.
+   size_t coalesce() {
+      #ifdef MEM_DEBUG
+      cout << "Coalescing memMgr..." << endl;
+      #endif // MEM_DEBUG
+      vector<pair<char*, size_t> > mems;   // (address, #Bytes)
+      for (size_t i = 0; i < R_SIZE + R_CLASS; ++i)
+         for (MemRecycleList<T>* l = (i < R_SIZE)? &_recycleList[i]:
+              &_classList[i - R_SIZE]; l; l = l->_nextList) {
+            size_t t = getMemSize(l->_arrSize);
+            for (T* p = l->_first; p; p = *(T**)p)
+               mems.push_back(make_pair((char*)p, t));
+            l->_first = 0; l->_numElm = 0;
+         }
+      clearNonEmpty();
+      _recycledSize = _coalesceSize = 0;
+      if (mems.empty()) return 0;
+      sort(mems.begin(), mems.end());
+      size_t j = 0;
+      for (size_t i = 1, n = mems.size(); i <= n; ++i) {
+         if (i < n && mems[j].first + mems[j].second == mems[i].first &&
+             MemBlock<T>::getMemBlock(mems[i].first, _blockAlign) ==
+             MemBlock<T>::getMemBlock(mems[j].first, _blockAlign)) {
+            mems[j].second += mems[i].second;
+            continue;
+         }
+         if (mems[j].first + mems[j].second == _activeBlock->_ptr &&
+             MemBlock<T>::getMemBlock(mems[j].first, _blockAlign) ==
+             _activeBlock)
+            _activeBlock->_ptr = mems[j].first;
+         else
+            recycleMem(mems[j].first, mems[j].second);
+         if (i < n) mems[++j] = mems[i];
+      }
+      return mems.size() - (j + 1);
+   }
+   // Fraction of the recycled memory and the free memory in the active
+   // block that is not in the largest contiguous piece of them
+   double getFragmentation() const {
+      size_t f = _recycledSize + _activeBlock->getRemainSize();
+      if (f == 0) return 0;
+      size_t m = _activeBlock->getRemainSize();
+      for (size_t i = 0; i < R_SIZE; ++i)
+         for (const MemRecycleList<T>* l = &_recycleList[i]; l; l = l->_nextList)
+            if (l->numElm() && getMemSize(l->_arrSize) > m)
+               m = getMemSize(l->_arrSize);
+      for (size_t i = 0; i < R_CLASS; ++i)
+         if (_classList[i].numElm() && getMemSize(_classList[i]._arrSize) > m)
+            m = getMemSize(_classList[i]._arrSize);
+      return 1 - double(m) / f;
+   }
+   void setReleaseThreshold(size_t n) { _releaseThreshold = n; }
+   // The event trace; recorded only after getTrace().start()
+   MemTrace& getTrace() { return _trace; }
+   size_t getReleaseThreshold() const { return _releaseThreshold; }
+   // Switch between the size-class mode (array sizes >= R_SIZE are
+   // rounded up to geometric classes with O(1) lookup) and the exact
+   // mode (one chained recycle list per array size), the default.
+   // The recycle lists are organized differently, so reset() first.
+   void setSizeClass(bool c) { reset(); _sizeClass = c; clearNonEmpty(); }
+   bool isSizeClass() const { return _sizeClass; }
    // Called by new
    T* alloc(size_t t) {
       assert(t == S);
@@ -241,7 +467,11 @@ public:
       #ifdef MEM_DEBUG
       cout << "Calling free...(" << p << ")" << endl;
       #endif // MEM_DEBUG
-      getMemRecycleList(0)->pushFront(p);
+      _trace.record(MEM_TRACE_FREE, p, getMemSize(0));
+      pushRecycled(getMemRecycleList(0), p);
+      _inUseSize -= getMemSize(0); ++_numFrees;
+      releaseObj(p);
+      checkRelease();
    }
    // Called by delete[]
    void  freeArr(T* p) {
@@ -253,12 +483,85 @@ public:
       // which is also the _recycleList index
       size_t n = 0;
       n = *(size_t*)p;
+      ++_numFrees;
+      if (isLargeMem(toSizeT(n * S + SIZE_T))) {
+         _inUseSize -= toSizeT(n * S + SIZE_T);
+         _trace.record(MEM_TRACE_FREE, p, toSizeT(n * S + SIZE_T));
+         #ifdef MEM_DEBUG
+         cout << ">> Array size = " << n << endl;
+         cout << "Releasing large object " << p << endl;
+         #endif // MEM_DEBUG
+         freeLargeMem(p);
+         return;
+      }
       #ifdef MEM_DEBUG
       cout << ">> Array size = " << n << endl;
       cout << "Recycling " << p << " to _recycleList[" << n << "]" << endl;
       #endif // MEM_DEBUG
       // add to recycle list...
-      getMemRecycleList(n)->pushFront(p);
+      MemRecycleList<T>* l = getMemRecycleList(n);
+      _trace.record(MEM_TRACE_FREE, p, getMemSize(l->_arrSize));
+      pushRecycled(l, p);
+      _inUseSize -= getMemSize(l->_arrSize);
+      releaseObj(p);
+      checkRelease();
+   }
+   // Called by MemMgrMT<T> to refill a magazine
+   // Get 'k' objects, chained through their first SIZE_T bytes.
+   // Return the first one and set 'last' to the last one.
+   // (Each object is counted as in use by its MemBlock until freeBatch())
+   T* allocBatch(size_t k, T*& last) {
+      assert(k > 0);
+      T* first = last = getMem(S);
+      for (size_t i = 1; i < k; ++i) {
+         T* p = getMem(S);
+         *(T**)last = p;
+         last = p;
+      }
+      *(T**)last = 0;
+      return first;
+   }
+   // Called by MemMgrMT<T> to return a magazine of objects
+   void freeBatch(T* first, T* last) {
+      size_t k = 0;
+      for (T* p = first; ; p = *(T**)p) {
+         _trace.record(MEM_TRACE_FREE, p, getMemSize(0));
+         releaseObj(p); ++k;
+         if (p == last) break;
+      }
+      MemRecycleList<T>* l = getMemRecycleList(0);
+      l->pushFront(first, last, k);
+      setNonEmpty(l);
+      _recycledSize += k * getMemSize(0);
+      _coalesceSize += k * getMemSize(0);
+      _compactSize += k * getMemSize(0);
+      _inUseSize -= k * getMemSize(0); _numFrees += k;
+      checkRelease();
+   }
+   // Dump the statistics as "name=value" lines, e.g. for scripts
+   void printStats(ostream& os) const {
+      os << "blockSize=" << _blockSize << endl
+         << "sizeClass=" << _sizeClass << endl
+         << "numBlocks=" << _numBlocks << endl
+         << "maxNumBlocks=" << _maxNumBlocks << endl
+         << "numFreeBlocks=" << getNumReleasable() << endl
+         << "freeInLastBlock=" << _activeBlock->getRemainSize() << endl
+         << "numLarge=" << _numLarge << endl
+         << "largeBytes=" << _largeSize << endl
+         << "inUseBytes=" << _inUseSize << endl
+         << "maxInUseBytes=" << _maxInUseSize << endl
+         << "recycledBytes=" << _recycledSize << endl
+         << "fragmentation=" << getFragmentation() << endl
+         << "numAllocs=" << _numAllocs << endl
+         << "numFrees=" << _numFrees << endl;
+      for (size_t i = 0; i < R_SIZE; ++i)
+         for (const MemRecycleList<T>* l = &_recycleList[i]; l; l = l->_nextList)
+            if (l->numElm())
+               os << "recycle[" << l->_arrSize << "]=" << l->numElm() << endl;
+      for (size_t i = 0; i < R_CLASS; ++i)
+         if (_classList[i].numElm())
+            os << "recycle[" << _classList[i]._arrSize << "]="
+               << _classList[i].numElm() << endl;
    }
    void print() const {
       cout << "=========================================" << endl
@@ -268,6 +571,10 @@ public:
            << "* Number of blocks      : " << getNumBlocks() << endl
            << "* Free mem in last block: " << _activeBlock->getRemainSize()
            << endl
+           << "* Large objects         : " << _numLarge << " ("
+           << _largeSize << " Bytes)" << endl
+           << "* Fragmentation         : " << setprecision(4)
+           << getFragmentation() * 100 << "%" << endl
            << "* Recycle list          : " << endl;
       int i = 0, count = 0;
       while (i < R_SIZE) {
@@ -283,13 +590,45 @@ public:
          }
          ++i;
       }
+      for (size_t j = 0; j < R_CLASS; ++j) {
+         size_t s = _classList[j].numElm();
+         if (s) {
+            cout << "[" << setw(3) << right << _classList[j]._arrSize << "] = "
+                 << setw(10) << left << s;
+            if (++count % 4 == 0) cout << endl;
+         }
+      }
       cout << endl;
    }
 
 private:
    size_t                     _blockSize;
+   size_t                     _blockAlign;           // see MemBlock
+   bool                       _sizeClass;
    MemBlock<T>*               _activeBlock;
    MemRecycleList<T>          _recycleList[R_SIZE];
+   MemRecycleList<T>          _classList[R_CLASS];   // for size-class mode
+   MemLargeObj<T>             _largeList;            // list head
+   size_t                     _numLarge;
+   size_t                     _largeSize;            // #Bytes mmap'ed
+   size_t                     _numFreeBlocks;        // with no _numObjs
+   size_t                     _releaseThreshold;
+   // Statistics; see printStats()
+   size_t                     _numBlocks;
+   size_t                     _maxNumBlocks;
+   size_t                     _inUseSize;            // #Bytes handed out
+   size_t                     _maxInUseSize;
+   size_t                     _recycledSize;         // #Bytes recycled
+   size_t                     _numAllocs;
+   size_t                     _numFrees;
+   // Bit i is set if the recycle list of index i may be non-empty; see
+   // getListByIdx() and getSplitMem().
+   vector<size_t>             _nonEmpty;
+   size_t                     _coalesceSize;   // #Bytes recycled since
+                                               // the last coalesce()
+   size_t                     _compactSize;    // ... since the last
+                                               // compact() by free
+   MemTrace                   _trace;
 
    // Private member functions
    //
@@ -306,6 +645,182 @@ private:
       size_t n = (t - SIZE_T) / S;
       return n;
    }
+   // The alignment of MemBlocks of size 'b'
+   static size_t getBlockAlign(size_t b) {
+      size_t a = 1;
+      while (a < MEM_BLOCK_HDR + b) a <<= 1;
+      return a;
+   }
+   // Count the memory 'p' (not a large object) as in use by its MemBlock
+   void acquireObj(T* p) {
+      MemBlock<T>* b = MemBlock<T>::getMemBlock(p, _blockAlign);
+      if (b->_numObjs++ == 0) --_numFreeBlocks;
+   }
+   // The memory 'p' is recycled
+   void releaseObj(T* p) {
+      MemBlock<T>* b = MemBlock<T>::getMemBlock(p, _blockAlign);
+      assert(b->_numObjs > 0);
+      if (--b->_numObjs == 0) ++_numFreeBlocks;
+   }
+   // #MemBlocks that compact() would release
+   size_t getNumReleasable() const {
+      return _numFreeBlocks - (_activeBlock->_numObjs == 0? 1: 0); }
+   // compact() walks all the recycle lists, so also wait until as much
+   // memory has been freed since the last compact() as is recycled;
+   // otherwise freeing many MemBlocks one by one costs quadratic time.
+   void checkRelease() {
+      if (_releaseThreshold != 0 && _compactSize >= _recycledSize &&
+          getNumReleasable() >= _releaseThreshold)
+         compact();
+   }
+   // Remove the memory in the to-be-released MemBlocks from 'l'
+   void compactRecycleList(MemRecycleList<T>* l) {
+      T** pp = &(l->_first);
+      while (*pp) {
+         MemBlock<T>* b = MemBlock<T>::getMemBlock(*pp, _blockAlign);
+         if (b->_numObjs == 0 && b != _activeBlock) {
+            *pp = *(T**)*pp;
+            --l->_numElm;
+            _recycledSize -= getMemSize(l->_arrSize);
+         }
+         else pp = (T**)*pp;
+      }
+   }
+   // In size-class mode, the list of index i is _recycleList[i]
+   // (i < R_SIZE) or _classList[i - R_SIZE]; in the exact mode, it is
+   // the list of array size i. The indices grow with the array sizes.
+   MemRecycleList<T>* getListByIdx(size_t i) {
+      if (!_sizeClass) return getMemRecycleList(i);
+      return (i < R_SIZE)? &_recycleList[i]: &_classList[i - R_SIZE]; }
+   // #List indices; arrays in the exact mode are no larger than a block
+   size_t getNumListIdx() const {
+      return _sizeClass? R_SIZE + R_CLASS: _blockSize / S + 1; }
+   void clearNonEmpty() { _nonEmpty.assign((getNumListIdx() + 63) / 64, 0); }
+   void setNonEmpty(const MemRecycleList<T>* l) {
+      size_t i = l->_arrSize;
+      if (_sizeClass)
+         i = (l >= _recycleList && l < _recycleList + R_SIZE)?
+             l - _recycleList: R_SIZE + (l - _classList);
+      _nonEmpty[i / 64] |= size_t(1) << (i % 64);
+   }
+   void pushRecycled(MemRecycleList<T>* l, T* p) {
+      l->pushFront(p);
+      setNonEmpty(l);
+      _recycledSize += getMemSize(l->_arrSize);
+      _coalesceSize += getMemSize(l->_arrSize);
+      _compactSize += getMemSize(l->_arrSize);
+   }
+   // Recycle the 't' Bytes of memory at 'p' in pieces of the largest
+   // possible array sizes. A remainder smaller than an object is lost.
+   void recycleMem(char* p, size_t t) {
+      while (t >= getMemSize(0)) {
+         MemRecycleList<T>* l = getMemRecycleList(getArraySize(t), false);
+         size_t s = getMemSize(l->_arrSize);
+         l->pushFront((T*)p);
+         setNonEmpty(l);
+         _recycledSize += s;
+         p += s; t -= s;
+      }
+   }
+   // Best fit: split the recycled memory of the smallest array size
+   // greater than 'n' to get 't' Bytes, and recycle the rest.
+   // Memory that would leave a remainder smaller than an object is
+   // skipped. Return 0 if not found.
+   T* getSplitMem(size_t n, size_t t) {
+      if (_recycledSize <= t) return 0;
+      size_t i = (n < R_SIZE || !_sizeClass)? n: R_SIZE + getSizeClass(n);
+      for (++i; i < getNumListIdx(); ++i) {
+         size_t w = _nonEmpty[i / 64] >> (i % 64);
+         if (w == 0) { i = (i / 64 + 1) * 64 - 1; continue; }
+         i += __builtin_ctzl(w);
+         if (i >= getNumListIdx()) break;
+         MemRecycleList<T>* l = getListByIdx(i);
+         if (l->_numElm == 0) {  // stale bit
+            _nonEmpty[i / 64] &= ~(size_t(1) << (i % 64));
+            continue;
+         }
+         size_t s = getMemSize(l->_arrSize);
+         if (s - t != 0 && s - t < getMemSize(0)) continue;
+         T* ret = l->popFront();
+         _recycledSize -= s;
+         recycleMem((char*)ret + t, s - t);
+         #ifdef MEM_DEBUG
+         cout << "Split from _recycleList[" << l->_arrSize << "]..." << ret
+              << endl;
+         #endif // MEM_DEBUG
+         return ret;
+      }
+      return 0;
+   }
+   // #Bytes of memory for an array of size 'n' (0: a single object)
+   size_t getMemSize(size_t n) const {
+      return n? toSizeT(n * S + SIZE_T): toSizeT(S); }
+   void addInUse(size_t t) {
+      ++_numAllocs;
+      if ((_inUseSize += t) > _maxInUseSize) _maxInUseSize = _inUseSize;
+   }
+   // Index of the highest set bit of 'n' (n > 0)
+   static size_t highBit(size_t n) {
+      return sizeof(size_t) * 8 - 1 - __builtin_clzl(n);
+   }
+   // Size class of array size 'n' (n >= R_SIZE) in _classList[].
+   // If "roundUp", return the smallest class that can hold 'n' elements
+   // (for allocation); otherwise the largest class whose array size <= n
+   // (for recycling a piece of memory that holds at least 'n' elements).
+   static size_t getSizeClass(size_t n, bool roundUp = true) {
+      assert(n >= R_SIZE);
+      size_t e = highBit(n);
+      size_t step = size_t(1) << (e - 2);     // R_CLASS_SUB == 4
+      size_t k = n >> (e - 2);                 // 4 <= k <= 7
+      if (roundUp && (n & (step - 1)))
+         if (++k == 2 * R_CLASS_SUB) { k = R_CLASS_SUB; ++e; }
+      assert((e - R_SIZE_LOG) * R_CLASS_SUB + (k - R_CLASS_SUB) < R_CLASS);
+      return (e - R_SIZE_LOG) * R_CLASS_SUB + (k - R_CLASS_SUB);
+   }
+   // The (maximum) array size of class 'c'
+   static size_t getClassArrSize(size_t c) {
+      size_t e = c / R_CLASS_SUB + R_SIZE_LOG;
+      return (R_CLASS_SUB + c % R_CLASS_SUB) << (e - 2);
+   }
+   // Round the array size 'n' up to its size class (size-class mode only)
+   size_t toClassArrSize(size_t n) const {
+      if (!_sizeClass || n < R_SIZE) return n;
+      return getClassArrSize(getSizeClass(n));
+   }
+   // Check if the request of 't' Bytes (a multiple of SIZE_T) is too large
+   // for a MemBlock, and so will be served by getLargeMem().
+   // Called by getMem() and freeArr(), which must agree on it.
+   bool isLargeMem(size_t t) const {
+      if (t > _blockSize) return true;
+      size_t n = getArraySize(t);
+      if (n < R_SIZE || !_sizeClass) return false;
+      return toSizeT(toClassArrSize(n) * S + SIZE_T) > _blockSize;
+   }
+   // mmap 't' Bytes for a large object; throw bad_alloc() if failed
+   T* getLargeMem(size_t t) {
+      size_t s = sizeof(MemLargeObj<T>) + t;
+      void* m = mmap(0, s, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (m == MAP_FAILED) {
+         cerr << "Requested memory (" << t << ") cannot be mapped. "
+              << "Exception raised...\n";
+         throw bad_alloc();
+      }
+      MemLargeObj<T>* l = (MemLargeObj<T>*)m;
+      l->_size = s;
+      l->insertAfter(&_largeList);
+      ++_numLarge; _largeSize += s;
+      #ifdef MEM_DEBUG
+      cout << "New large object... " << l->getMem() << endl;
+      #endif // MEM_DEBUG
+      return l->getMem();
+   }
+   void freeLargeMem(T* p) {
+      MemLargeObj<T>* l = MemLargeObj<T>::getLargeObj(p);
+      l->remove();
+      --_numLarge; _largeSize -= l->_size;
+      munmap(l, l->_size);
+   }
    // Go through _recycleList[m], its _nextList, and _nexList->_nextList, etc,
    //    to find a recycle list whose "_arrSize" == "n"
    // If not found, create a new MemRecycleList with _arrSize = n
@@ -314,7 +829,15 @@ private:
    // [Note]: This function will be called by MemMgr->getMem() to get the
    //         recycle list. Therefore, the recycle list is first created
    //         by the MTNew command, not MTDelete.
-   MemRecycleList<T>* getMemRecycleList(size_t n) {
+   //
+   // In size-class mode, _recycleList[n] (n < R_SIZE) or the class list
+   // is returned directly, so no list is ever chained.
+   // 'roundUp' is as in getSizeClass().
+   MemRecycleList<T>* getMemRecycleList(size_t n, bool roundUp = true) {
+      if (_sizeClass) {
+         if (n < R_SIZE) return &(_recycleList[n]);
+         return &(_classList[getSizeClass(n, roundUp)]);
+      }
       size_t m = n % R_SIZE;
       // TODO
       MemRecycleList<T>* targetList = &(_recycleList[m]);
@@ -341,15 +864,13 @@ private:
       // 1. Make sure to promote t to a multiple of SIZE_T
       t = toSizeT(t);
       // 2. Check if the requested memory is greater than the block size.
-      //    If so, throw a "bad_alloc()" exception.
-      //    Print this message for exception
-      //    cerr << "Requested memory (" << t << ") is greater than block size"
-      //         << "(" << _blockSize << "). " << "Exception raised...\n";
-      // TODO
-      if(t > _blockSize){
-         cerr << "Requested memory (" << t << ") is greater than block size"
-              << "(" << _blockSize << "). " << "Exception raised...\n";
-         throw bad_alloc();
+      //    If so, get it from a separate mmap (freed by freeArr()),
+      //    so that _blockSize can be tuned for the small objects only.
+      if (isLargeMem(t)) {
+         addInUse(t);
+         ret = getLargeMem(t);
+         _trace.record(MEM_TRACE_ALLOC, ret, t);
+         return ret;
       }
 
       // 3. Check the _recycleList first...
@@ -360,13 +881,37 @@ private:
       //    => 'n' is the size of array
       //    => "ret" is the return address
       size_t n = getArraySize(t);
+      // In size-class mode, allocate the whole class so that any
+      // memory recycled to this class can serve any request of it
+      if (n >= R_SIZE && _sizeClass) {
+         n = toClassArrSize(n);
+         t = toSizeT(n * S + SIZE_T);
+      }
+      addInUse(t);
       // TODO
       ret = getMemRecycleList(n)->popFront();
       if(ret)// ret != 0, point to something in recycleList[n]
       {
+         _recycledSize -= getMemSize(n);
          #ifdef MEM_DEBUG
          cout << "Recycled from _recycleList[" << n << "]..." << ret << endl;
          #endif // MEM_DEBUG
+         _trace.record(MEM_TRACE_RECYCLE, ret, t);
+         acquireObj(ret);
+         return ret;
+      }
+      ret = getSplitMem(n, t);
+      // Coalesce before a new MemBlock is needed, if worthwhile
+      if (!ret && _activeBlock->getRemainSize() < t &&
+          _coalesceSize >= _blockSize &&
+          _coalesceSize >= _recycledSize && coalesce()) {
+         ret = getMemRecycleList(n)->popFront();
+         if (ret) _recycledSize -= getMemSize(n);
+         else ret = getSplitMem(n, t);
+      }
+      if (ret) {
+         _trace.record(MEM_TRACE_RECYCLE, ret, t);
+         acquireObj(ret);
          return ret;
       }
 
@@ -384,26 +929,31 @@ private:
       //    cout << "New MemBlock... " << _activeBlock << endl;
       //    #endif // MEM_DEBUG
       // TODO
-      else if(!_activeBlock->getMem(t, ret)) //not enough
+      if(!_activeBlock->getMem(t, ret)) //not enough
       {
          size_t remainSize = _activeBlock->getRemainSize();
-         if(remainSize >= S) //recycle the remain to recyclieList
-         {
-            size_t rn = getArraySize(remainSize);
-            getMemRecycleList(rn)->pushFront(ret);
-            #ifdef MEM_DEBUG
-            cout << "Recycling " << ret << " to _recycleList[" << rn << "]\n";
-            #endif // MEM_DEBUG
-         }
+         #ifdef MEM_DEBUG
+         if (remainSize >= S)
+            cout << "Recycling " << ret << " to _recycleList["
+                 << getArraySize(remainSize) << "]\n";
+         #endif // MEM_DEBUG
+         recycleMem((char*)ret, remainSize);
          //create new MemBlock
-         MemBlock<T>* newMemBlock = new MemBlock<T>(_activeBlock, _blockSize);
+         MemBlock<T>* newMemBlock =
+            new MemBlock<T>(_activeBlock, _blockSize, _blockAlign);
          _activeBlock = newMemBlock;
+         ++_numFreeBlocks;
+         if (++_numBlocks > _maxNumBlocks) _maxNumBlocks = _numBlocks;
          #ifdef MEM_DEBUG
          cout << "New MemBlock... " << _activeBlock << endl;
          #endif // MEM_DEBUG
+         _trace.record(MEM_TRACE_NEW_BLOCK, _activeBlock->_begin, _blockSize);
          _activeBlock->getMem(t, ret);
       }
 
+      _trace.record(MEM_TRACE_ALLOC, ret, t);
+      acquireObj(ret);
+
       // 6. At the end, print out the acquired memory address
       #ifdef MEM_DEBUG
       cout << "Memory acquired... " << ret << endl;
@@ -411,16 +961,226 @@ private:
       return ret;
    }
    // Get the currently allocated number of MemBlock's
-   size_t getNumBlocks() const {
-      // TODO
-      size_t cnt = 0;
-      MemBlock<T>* tmp = _activeBlock;
-      while(tmp)
+   size_t getNumBlocks() const { return _numBlocks; }
+};
+
+//--------------------------------------------------------------------------
+// Thread-safe memory manager
+//--------------------------------------------------------------------------
+// Each thread caches recycled objects in two magazines (loaded/previous)
+// of at most _magSize objects, so that new/delete do not lock at all
+// unless the magazines run empty/full. Then a whole magazine is
+// exchanged with the shared depot, which keeps up to _maxDepot full
+// magazines and carves new ones from a MemMgr<T> under a mutex; a full
+// magazine beyond that is freed back to the MemMgr<T>, so that a burst of
+// deletes does not keep its memory out of the recycle lists.
+// Arrays (new[]/delete[]) always go to the MemMgr<T> under the mutex.
+//
+// reset() must not race with other threads using the manager.
+// Magazines cached by other threads are dropped lazily (by _epoch).
+// The magazines are kept per thread and per manager, so there can be
+// several managers of one T; a manager must not be destroyed while
+// other threads use it. When a thread exits, its magazines go back to
+// the managers that are still alive.
+//
+#define MAG_SIZE 64
+#define MAG_DEPOT_SIZE 16
+
+// Make it a private class;
+// Only friend to MemMgrMT;
+//
+template <class T>
+class MemMagazine
+{
+   friend class MemMgrMT<T>;
+
+   MemMagazine() : _first(0), _last(0), _size(0) {}
+
+   bool empty() const { return _size == 0; }
+   void push(T* p) {
+      *(T**)p = _first;
+      if (!_first) _last = p;
+      _first = p; ++_size;
+   }
+   T* pop() {
+      T* p = _first;
+      _first = *(T**)p;
+      if (--_size == 0) _last = 0;
+      return p;
+   }
+   void clear() { _first = _last = 0; _size = 0; }
+
+   T*       _first;
+   T*       _last;
+   size_t   _size;
+};
+
+template <class T>
+class MemMgrMT
+{
+   #define S sizeof(T)
+
+   // A thread's magazines of one manager
+   struct MemMagCache {
+      MemMagCache(MemMgrMT<T>* m) : _mgr(m), _id(m->_id), _epoch(m->_epoch) {}
+
+      MemMgrMT<T>*      _mgr;
+      size_t            _id;       // _mgr->_id
+      size_t            _epoch;
+      MemMagazine<T>    _loaded;
+      MemMagazine<T>    _previous;
+   };
+   // Per-thread magazine caches, one per manager used by the thread;
+   // return the cached objects to the live managers when the thread exits
+   struct MemMagCaches {
+      ~MemMagCaches() {
+         lock_guard<mutex> lock(getLiveMutex());
+         for (size_t i = 0; i < _caches.size(); ++i)
+            if (isLive(_caches[i]._id))
+               _caches[i]._mgr->flush(_caches[i]);
+      }
+
+      vector<MemMagCache>  _caches;
+   };
+
+public:
+   MemMgrMT(size_t b = 65536, size_t m = MAG_SIZE, size_t d = MAG_DEPOT_SIZE)
+   : _magSize(m), _maxDepot(d), _memMgr(b), _epoch(0) {
+      assert(m > 0);
+      lock_guard<mutex> lock(getLiveMutex());
+      _id = ++getNumCreated();
+      getLiveIds().push_back(_id);
+   }
+   ~MemMgrMT() {
+      lock_guard<mutex> lock(getLiveMutex());
+      vector<size_t>& l = getLiveIds();
+      l.erase(find(l.begin(), l.end(), _id));
+   }
+
+   void reset(size_t b = 0) {
+      lock_guard<mutex> lock(_mutex);
+      _depot.clear();
+      _memMgr.reset(b);
+      ++_epoch;
+   }
+   // Called by new
+   T* alloc(size_t t) {
+      assert(t == S);
+      MemMagCache& c = getCache();
+      if (c._loaded.empty()) {
+         if (c._previous.empty()) refill(c._loaded);
+         else swap(c._loaded, c._previous);
+      }
+      return c._loaded.pop();
+   }
+   // Called by new[]
+   T* allocArr(size_t t) {
+      lock_guard<mutex> lock(_mutex);
+      return _memMgr.allocArr(t);
+   }
+   // Called by delete
+   void free(T* p) {
+      MemMagCache& c = getCache();
+      if (c._loaded._size == _magSize) {
+         if (!c._previous.empty()) exchange(c._previous);
+         swap(c._loaded, c._previous);
+      }
+      c._loaded.push(p);
+   }
+   // Called by delete[]
+   void freeArr(T* p) {
+      lock_guard<mutex> lock(_mutex);
+      _memMgr.freeArr(p);
+   }
+   void print() {
+      lock_guard<mutex> lock(_mutex);
+      _memMgr.print();
+      cout << "* Magazine size         : " << _magSize << endl
+           << "* Magazines in depot    : " << _depot.size() << " (max "
+           << _maxDepot << ")" << endl;
+   }
+
+private:
+   size_t                     _magSize;
+   size_t                     _maxDepot; // #full magazines kept in _depot
+   MemMgr<T>                  _memMgr;   // the depot for new magazines
+   vector<MemMagazine<T> >    _depot;    // full magazines
+   mutex                      _mutex;
+   atomic<size_t>             _epoch;
+   size_t                     _id;       // unique among the managers of T
+
+   // Private member functions
+   //
+   // The managers of T alive, by _id, guarded by getLiveMutex()
+   static mutex& getLiveMutex() { static mutex m; return m; }
+   static vector<size_t>& getLiveIds() { static vector<size_t> l; return l; }
+   static size_t& getNumCreated() { static size_t n = 0; return n; }
+   static bool isLive(size_t id) {
+      const vector<size_t>& l = getLiveIds();
+      return find(l.begin(), l.end(), id) != l.end();
+   }
+   // Get the calling thread's magazines of this manager.
+   // Drop them if they were filled before the last reset().
+   MemMagCache& getCache() {
+      // The one used last; a plain pointer needs no per-access TLS guard
+      static thread_local MemMagCache* last = 0;
+      if (!last || last->_id != _id)
+         last = findCache();
+      MemMagCache& c = *last;
+      if (c._epoch != _epoch.load(memory_order_relaxed)) {
+         c._loaded.clear(); c._previous.clear();
+         c._epoch = _epoch;
+      }
+      return c;
+   }
+   // The calling thread's magazines of this manager.
+   // If not found, add them, and drop those of the destroyed managers.
+   MemMagCache* findCache() {
+      static thread_local MemMagCaches cs;
+      for (size_t i = 0; i < cs._caches.size(); ++i)
+         if (cs._caches[i]._id == _id) return &cs._caches[i];
       {
-         cnt++;
-         tmp = tmp->getNextBlock();
+         lock_guard<mutex> lock(getLiveMutex());
+         size_t j = 0;
+         for (size_t i = 0; i < cs._caches.size(); ++i)
+            if (isLive(cs._caches[i]._id)) cs._caches[j++] = cs._caches[i];
+         cs._caches.erase(cs._caches.begin() + j, cs._caches.end());
+      }
+      cs._caches.push_back(MemMagCache(this));
+      return &cs._caches.back();
+   }
+   // Fill the empty magazine 'm' from the depot
+   void refill(MemMagazine<T>& m) {
+      lock_guard<mutex> lock(_mutex);
+      if (!_depot.empty()) {
+         m = _depot.back();
+         _depot.pop_back();
+      }
+      else {
+         m._first = _memMgr.allocBatch(_magSize, m._last);
+         m._size = _magSize;
+      }
+   }
+   // Hand the full magazine 'm' over to the depot, or back to _memMgr
+   // if the depot is full
+   void exchange(MemMagazine<T>& m) {
+      lock_guard<mutex> lock(_mutex);
+      if (_depot.size() < _maxDepot)
+         _depot.push_back(m);
+      else
+         _memMgr.freeBatch(m._first, m._last);
+      m.clear();
+   }
+   // Return all the objects cached in 'c' (called at thread exit)
+   void flush(MemMagCache& c) {
+      lock_guard<mutex> lock(_mutex);
+      if (c._epoch == _epoch) {
+         if (!c._loaded.empty())
+            _memMgr.freeBatch(c._loaded._first, c._loaded._last);
+         if (!c._previous.empty())
+            _memMgr.freeBatch(c._previous._first, c._previous._last);
       }
-      return cnt;
+      c._loaded.clear(); c._previous.clear();
    }
 };
 
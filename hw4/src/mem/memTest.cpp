@@ -5,13 +5,58 @@
   Author       [ Chung-Yang (Ric) Huang ]
   Copyright    [ Copyleft(c) 2007-present LaDs(III), GIEE, NTU, Taiwan ]
 ****************************************************************************/
+#include <thread>
+#include <chrono>
 #include "memTest.h"
 
 using namespace std;
 
 #ifdef MEM_MGR_H
 MEM_MGR_INIT(MemTestObj);
+MEM_MGR_MT_INIT(MemTestObjMT);
 #endif // MEM_MGR_H
 
 MemTest mtest;
 
+// rnGen() is not thread-safe; each stress thread uses its own xorshift
+static inline size_t
+stressRand(size_t& x)
+{
+   x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+   return x;
+}
+
+static void
+stressThread(size_t seed, size_t n, size_t s)
+{
+   vector<MemTestObjMT*> objs(n);
+   size_t x = seed * 2654435761u + 1;
+   for (size_t i = 0; i < n; ++i)
+      objs[i] = s? new MemTestObjMT[s]: new MemTestObjMT;
+   for (size_t i = 0; i < n / 2; ++i) {
+      size_t j = stressRand(x) % n;
+      if (s) delete[] objs[j]; else delete objs[j];
+      objs[j] = s? new MemTestObjMT[s]: new MemTestObjMT;
+   }
+   for (size_t i = n; i > 0; --i) {
+      size_t j = stressRand(x) % i;
+      if (s) delete[] objs[j]; else delete objs[j];
+      objs[j] = objs[i - 1];
+   }
+}
+
+double
+MemTest::stress(size_t t, size_t n, size_t s, size_t& nAlloc) const
+{
+   vector<thread> threads;
+   threads.reserve(t);
+   chrono::steady_clock::time_point start = chrono::steady_clock::now();
+   for (size_t i = 0; i < t; ++i)
+      threads.push_back(thread(stressThread, i + 1, n, s));
+   for (size_t i = 0; i < t; ++i)
+      threads[i].join();
+   chrono::duration<double> d = chrono::steady_clock::now() - start;
+   nAlloc = t * (n + n / 2);
+   return d.count();
+}
+
@@ -39,6 +39,27 @@ private:
    char    _dataC;     // 4*1 (1)
 };              // Total: 4*11 = 44 Bytes
 
+// Same as MemTestObj, but managed by the thread-safe MemMgrMT
+//
+class MemTestObjMT
+{
+friend class MemTest;
+#ifdef MEM_MGR_H
+   USE_MEM_MGR_MT(MemTestObjMT);
+#endif // MEM_MGR_H
+
+public:
+   MemTestObjMT() {}
+   virtual ~MemTestObjMT() {}
+
+private:
+   short   _dataSI;
+   int     _dataI[5];
+   bool    _dataB;
+   float   _dataF[3];
+   char    _dataC;
+};
+
 
 class MemTest
 {
@@ -52,6 +73,20 @@ public:
       MemTestObj::memReset(b);
       #endif // MEM_MGR_H
    }
+   // Coalesce the recycled memory and release the fully-recycled
+   // MemBlocks; return the #Bytes released
+   size_t compact() {
+      #ifdef MEM_MGR_H
+      return MemTestObj::memCompact();
+      #else
+      return 0;
+      #endif // MEM_MGR_H
+   }
+   void setReleaseThreshold(size_t n) {
+      #ifdef MEM_MGR_H
+      MemTestObj::memSetReleaseThreshold(n);
+      #endif // MEM_MGR_H
+   }
    size_t getObjListSize() const { return _objList.size(); }
    size_t getArrListSize() const { return _arrList.size(); }
 
@@ -75,7 +110,29 @@ public:
       assert(idx < _arrList.size());
       if (_arrList[idx] != 0) { delete[] _arrList[idx]; _arrList[idx] = 0; }
    }
+   // Multi-threaded new/delete stress test on MemTestObjMT (in memTest.cpp)
+   // Each of the "t" threads allocates "n" objects (or arrays of size "s"
+   // if s > 0), deletes a random half of them, allocates them again,
+   // and finally deletes them all in random order.
+   // Return the wall-clock time in seconds; "nAlloc" is the #allocations
+   double stress(size_t t, size_t n, size_t s, size_t& nAlloc) const;
 
+   // The event trace of the memory manager; 0 if not managed
+   MemTrace* getTrace() const {
+      #ifdef MEM_MGR_H
+      return &MemTestObj::memTrace();
+      #else
+      return 0;
+      #endif // MEM_MGR_H
+   }
+   // Machine-readable statistics of the memory manager
+   void printStats() const {
+      #ifdef MEM_MGR_H
+      MemTestObj::memPrintStats(cout);
+      #endif // MEM_MGR_H
+      cout << "objListSize=" << _objList.size() << endl
+           << "arrListSize=" << _arrList.size() << endl;
+   }
    void print() const {
       #ifdef MEM_MGR_H
       MemTestObj::memPrint();
@@ -0,0 +1,130 @@
+/****************************************************************************
+  FileName     [ memTrace.cpp ]
+  PackageName  [ mem ]
+  Synopsis     [ Dump and summarize the event trace of memory manager ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2007-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+#include <fstream>
+#include <iomanip>
+#include <cstring>
+#include <unordered_map>
+#include "memTrace.h"
+
+using namespace std;
+
+// Dump file: MEM_TRACE_MAGIC, #records in file, #records traced,
+//            then the MemTraceRec's, oldest first
+static const char MEM_TRACE_MAGIC[8] = { 'M','E','M','T','R','A','C','E' };
+
+// floor(log2(v)); 0 for v == 0
+static size_t
+log2Floor(uint64_t v)
+{
+   size_t b = 0;
+   while (v >>= 1) ++b;
+   return b;
+}
+
+static void
+printHistogram(ostream& os, const vector<size_t>& hist)
+{
+   size_t maxCnt = 0, first = hist.size(), last = 0;
+   for (size_t b = 0; b < hist.size(); ++b) {
+      if (!hist[b]) continue;
+      if (hist[b] > maxCnt) maxCnt = hist[b];
+      if (first == hist.size()) first = b;
+      last = b;
+   }
+   for (size_t b = first; b <= last && b < hist.size(); ++b) {
+      uint64_t lo = (b == 0)? 0: (uint64_t(1) << b);
+      uint64_t hi = (uint64_t(1) << (b + 1)) - 1;
+      os << "[" << setw(11) << right << lo << ", " << setw(11) << hi
+         << "] : " << setw(10) << hist[b] << "  "
+         << string(maxCnt? (hist[b] * 40 + maxCnt - 1) / maxCnt: 0, '#')
+         << endl;
+   }
+}
+
+bool
+MemTrace::dump(const string& f) const
+{
+   ofstream ofs(f.c_str(), ios::binary);
+   if (!ofs) return false;
+   uint64_t kept = getNumKept(), tot = _numRecs;
+   ofs.write(MEM_TRACE_MAGIC, sizeof(MEM_TRACE_MAGIC));
+   ofs.write((const char*)&kept, sizeof(kept));
+   ofs.write((const char*)&tot, sizeof(tot));
+   // The oldest event is at _next once the buffer has wrapped around
+   size_t i = (_numRecs > _buf.size())? _next: 0;
+   for (size_t k = 0; k < kept; ++k) {
+      ofs.write((const char*)&_buf[i], sizeof(MemTraceRec));
+      if (++i == _buf.size()) i = 0;
+   }
+   return bool(ofs);
+}
+
+bool
+MemTrace::summarize(const string& f, ostream& os)
+{
+   ifstream ifs(f.c_str(), ios::binary);
+   if (!ifs) return false;
+   char magic[sizeof(MEM_TRACE_MAGIC)];
+   uint64_t kept, tot;
+   ifs.read(magic, sizeof(magic));
+   ifs.read((char*)&kept, sizeof(kept));
+   ifs.read((char*)&tot, sizeof(tot));
+   if (!ifs || memcmp(magic, MEM_TRACE_MAGIC, sizeof(magic)) != 0)
+      return false;
+
+   size_t numType[MEM_TRACE_TOT] = { 0 };
+   vector<size_t> sizeHist(64, 0), lifeHist(64, 0);
+   unordered_map<uint64_t, uint64_t> live;   // address -> allocated time
+   size_t numFreed = 0, numUnknown = 0;
+   uint64_t sumLife = 0, t0 = 0, t1 = 0;
+   MemTraceRec r;
+   for (uint64_t k = 0; k < kept; ++k) {
+      if (!ifs.read((char*)&r, sizeof(r)) || r._type >= MEM_TRACE_TOT)
+         return false;
+      if (k == 0) t0 = r._time;
+      t1 = r._time;
+      ++numType[r._type];
+      switch (r._type) {
+         case MEM_TRACE_ALLOC: case MEM_TRACE_RECYCLE:
+            ++sizeHist[log2Floor(r._size)];
+            live[r._addr] = r._time;
+            break;
+         case MEM_TRACE_FREE: {
+            unordered_map<uint64_t, uint64_t>::iterator it
+               = live.find(r._addr);
+            // allocated before the trace (or before the kept events)
+            if (it == live.end()) { ++numUnknown; break; }
+            uint64_t life = r._time - it->second;
+            ++lifeHist[log2Floor(life)];
+            sumLife += life; ++numFreed;
+            live.erase(it);
+            break;
+         }
+         default: break;
+      }
+   }
+
+   os << "Trace file    : " << f << endl
+      << "Events        : " << kept << " (" << tot - kept
+      << " overwritten)" << endl
+      << "  Alloc       : " << numType[MEM_TRACE_ALLOC] << endl
+      << "  Recycle     : " << numType[MEM_TRACE_RECYCLE] << endl
+      << "  Free        : " << numType[MEM_TRACE_FREE] << endl
+      << "  New block   : " << numType[MEM_TRACE_NEW_BLOCK] << endl
+      << "Time span     : " << t1 - t0 << " ns" << endl << endl
+      << "Allocation size (Bytes) ---" << endl;
+   printHistogram(os, sizeHist);
+   os << endl << "Lifetime (ns) ---" << endl;
+   printHistogram(os, lifeHist);
+   os << endl << "Freed objects : " << numFreed;
+   if (numFreed) os << " (mean lifetime " << sumLife / numFreed << " ns)";
+   os << endl
+      << "Still in use  : " << live.size() << endl
+      << "Freed only    : " << numUnknown << endl;
+   return true;
+}
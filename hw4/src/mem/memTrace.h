@@ -0,0 +1,96 @@
+/****************************************************************************
+  FileName     [ memTrace.h ]
+  PackageName  [ mem ]
+  Synopsis     [ Define the event trace of memory manager ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2007-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#ifndef MEM_TRACE_H
+#define MEM_TRACE_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <stdint.h>
+
+using namespace std;
+
+//--------------------------------------------------------------------------
+// Event trace of MemMgr
+//--------------------------------------------------------------------------
+// Unlike the MEM_DEBUG messages, tracing is switched on and off at run
+// time. When off, each event costs one predictable branch; when on,
+// the events are stored in a ring buffer (the oldest are overwritten)
+// which can be dumped to a binary file and summarized offline.
+//
+enum MemTraceType
+{
+   MEM_TRACE_ALLOC,      // memory taken from a MemBlock or a large mmap
+   MEM_TRACE_RECYCLE,    // memory taken from a recycle list
+   MEM_TRACE_FREE,       // memory returned by delete or delete[]
+   MEM_TRACE_NEW_BLOCK,  // a new MemBlock of _blockSize Bytes
+
+   MEM_TRACE_TOT
+};
+
+// One event; also the record format of the dump file
+struct MemTraceRec
+{
+   uint64_t    _time;    // ns since the trace was turned on
+   uint64_t    _addr;
+   uint32_t    _size;    // #Bytes
+   uint32_t    _type;    // MemTraceType
+};
+
+class MemTrace
+{
+public:
+   MemTrace() : _on(false), _next(0), _numRecs(0) {}
+   ~MemTrace() {}
+
+   // Start a new trace with a ring buffer of 'n' events
+   void start(size_t n) {
+      _buf.assign(n? n: 1, MemTraceRec());
+      _next = _numRecs = 0;
+      _start = chrono::steady_clock::now();
+      _on = true;
+   }
+   // Stop recording; the recorded events are kept for dump()
+   void stop() { _on = false; }
+   bool isOn() const { return _on; }
+   void record(MemTraceType type, const void* p, size_t t) {
+      if (!_on) return;
+      MemTraceRec& r = _buf[_next];
+      r._time = chrono::duration_cast<chrono::nanoseconds>
+                (chrono::steady_clock::now() - _start).count();
+      r._addr = uint64_t(size_t(p));
+      r._size = uint32_t(t);
+      r._type = type;
+      if (++_next == _buf.size()) _next = 0;
+      ++_numRecs;
+   }
+   // #events recorded, including those overwritten
+   size_t getNumRecs() const { return _numRecs; }
+   // #events in the buffer
+   size_t getNumKept() const {
+      return (_numRecs < _buf.size())? _numRecs: _buf.size(); }
+
+   // Dump the kept events, oldest first, to the binary file 'f'
+   // (in memTrace.cpp); return false if the file cannot be written
+   bool dump(const string& f) const;
+   // Read the dump file 'f' and print the allocation size histogram
+   // and the object lifetimes to 'os'; return false if 'f' is not
+   // a valid dump file
+   static bool summarize(const string& f, ostream& os);
+
+private:
+   bool                                   _on;
+   vector<MemTraceRec>                    _buf;
+   size_t                                 _next;     // next slot in _buf
+   size_t                                 _numRecs;
+   chrono::steady_clock::time_point       _start;
+};
+
+#endif // MEM_TRACE_H
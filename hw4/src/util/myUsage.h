@@ -48,6 +48,9 @@ public:
       }
    }
 
+   // Peak memory (resident set size) of this process in MB
+   double getPeakMem() const { return checkMem(); }
+
 private:
    // for Memory usage (in MB)
    double     _initMem;
@@ -1,7 +1,24 @@
-cirGate.o: cirGate.cpp cirGate.h cirDef.h cirMgr.h ../../include/util.h \
- ../../include/rnGen.h ../../include/myUsage.h
-cirMgr.o: cirMgr.cpp cirMgr.h cirDef.h cirGate.h ../../include/util.h \
- ../../include/rnGen.h ../../include/myUsage.h
-cirCmd.o: cirCmd.cpp cirMgr.h cirDef.h cirGate.h cirCmd.h \
- ../../include/cmdParser.h ../../include/cmdCharDef.h \
+cirGate.o: cirGate.cpp cirGate.h cirDef.h cirMgr.h ../../include/myPool.h \
  ../../include/util.h ../../include/rnGen.h ../../include/myUsage.h
+cirMgr.o: cirMgr.cpp cirMgr.h cirDef.h cirGate.h ../../include/myPool.h \
+ cirCompact.h \
+ ../../include/myThread.h \
+ ../../include/util.h ../../include/rnGen.h ../../include/myUsage.h
+cirCmd.o: cirCmd.cpp cirMgr.h cirDef.h cirGate.h ../../include/myPool.h \
+ cirCompact.h \
+ cirCmd.h ../../include/cmdParser.h ../../include/cmdCharDef.h \
+ ../../include/util.h ../../include/rnGen.h ../../include/myUsage.h
+cirCompact.o: cirCompact.cpp cirCompact.h cirDef.h cirGate.h \
+ ../../include/myPool.h ../../include/util.h ../../include/rnGen.h \
+ ../../include/myUsage.h
+cirSim.o: cirSim.cpp cirMgr.h cirDef.h cirGate.h ../../include/myPool.h \
+ cirCompact.h ../../include/util.h ../../include/rnGen.h \
+ ../../include/myUsage.h ../../include/myThread.h \
+ ../../include/myHashSet.h
+cirOpt.o: cirOpt.cpp cirMgr.h cirDef.h cirGate.h ../../include/myPool.h \
+ cirCompact.h ../../include/util.h ../../include/rnGen.h \
+ ../../include/myUsage.h
+cirFraig.o: cirFraig.cpp cirMgr.h cirDef.h cirGate.h ../../include/myPool.h \
+ cirCompact.h cirSat.h ../../include/util.h ../../include/rnGen.h \
+ ../../include/myUsage.h
+cirSat.o: cirSat.cpp cirSat.h
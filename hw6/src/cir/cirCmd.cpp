@@ -24,7 +24,13 @@ initCirCmd()
    if (!(cmdMgr->regCmd("CIRRead", 4, new CirReadCmd) &&
          cmdMgr->regCmd("CIRPrint", 4, new CirPrintCmd) &&
          cmdMgr->regCmd("CIRGate", 4, new CirGateCmd) &&
-         cmdMgr->regCmd("CIRWrite", 4, new CirWriteCmd)
+         cmdMgr->regCmd("CIRWrite", 4, new CirWriteCmd) &&
+         cmdMgr->regCmd("CIRSIMulate", 6, new CirSimCmd) &&
+         cmdMgr->regCmd("CIRSWeep", 5, new CirSweepCmd) &&
+         cmdMgr->regCmd("CIROPTimize", 6, new CirOptCmd) &&
+         cmdMgr->regCmd("CIRSTRash", 6, new CirStrashCmd) &&
+         cmdMgr->regCmd("CIRFraig", 4, new CirFraigCmd) &&
+         cmdMgr->regCmd("CIREQuiv", 5, new CirEquivCmd)
       )) {
       cerr << "Registering \"cir\" commands fails... exiting" << endl;
       return false;
@@ -37,14 +43,32 @@ enum CirCmdState
    // Order matters! Do not change the order!!
    CIRINIT,
    CIRREAD,
+   CIRSIMULATE,
+   CIRSWEEP,
+   CIROPT,
+   CIRSTRASH,
+   CIRFRAIG,
    // dummy end
    CIRCMDTOT
 };
 
 static CirCmdState curCmd = CIRINIT;
 
+// Only the reporting and writing commands work on a compact circuit
+static bool
+checkNotCompact()
+{
+   if (cirMgr->isCompact()) {
+      cerr << "Error: the circuit is compact; only reporting and writing "
+           << "are supported!!" << endl;
+      return false;
+   }
+   return true;
+}
+
 //----------------------------------------------------------------------
-//    CIRRead <(string fileName)> [-Replace]
+//    CIRRead <(string fileName)> [-Replace] [-Compact]
+//            [-Thread (int numThreads)]
 //----------------------------------------------------------------------
 CmdExecStatus
 CirReadCmd::exec(const string& option)
@@ -56,13 +80,25 @@ CirReadCmd::exec(const string& option)
    if (options.empty())
       return CmdExec::errorOption(CMD_OPT_MISSING, "");
 
-   bool doReplace = false;
+   bool doReplace = false, doCompact = false;
+   int numThreads = 0;
    string fileName;
    for (size_t i = 0, n = options.size(); i < n; ++i) {
       if (myStrNCmp("-Replace", options[i], 2) == 0) {
          if (doReplace) return CmdExec::errorOption(CMD_OPT_EXTRA,options[i]);
          doReplace = true;
       }
+      else if (myStrNCmp("-Compact", options[i], 2) == 0) {
+         if (doCompact) return CmdExec::errorOption(CMD_OPT_EXTRA,options[i]);
+         doCompact = true;
+      }
+      else if (myStrNCmp("-Thread", options[i], 2) == 0) {
+         if (numThreads) return CmdExec::errorOption(CMD_OPT_EXTRA,options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i - 1]);
+         if (!myStr2Int(options[i], numThreads) || numThreads <= 0)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+      }
       else {
          if (fileName.size())
             return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
@@ -82,12 +118,14 @@ CirReadCmd::exec(const string& option)
       }
    }
    cirMgr = new CirMgr;
+   if (numThreads) cirMgr->setNumThreads(numThreads);
 
    if (!cirMgr->readCircuit(fileName)) {
       curCmd = CIRINIT;
       delete cirMgr; cirMgr = 0;
       return CMD_EXEC_ERROR;
    }
+   if (doCompact) cirMgr->compact();
 
    curCmd = CIRREAD;
 
@@ -97,7 +135,8 @@ CirReadCmd::exec(const string& option)
 void
 CirReadCmd::usage(ostream& os) const
 {
-   os << "Usage: CIRRead <(string fileName)> [-Replace]" << endl;
+   os << "Usage: CIRRead <(string fileName)> [-Replace] [-Compact]" << endl
+      << "               [-Thread (int numThreads)]" << endl;
 }
 
 void
@@ -108,7 +147,8 @@ CirReadCmd::help() const
 }
 
 //----------------------------------------------------------------------
-//    CIRPrint [-Summary | -Netlist | -PI | -PO | -FLoating ]
+//    CIRPrint [-Summary | -Netlist | -PI | -PO | -FLoating | -MEMory
+//              | -FECpairs]
 //----------------------------------------------------------------------
 CmdExecStatus
 CirPrintCmd::exec(const string& option)
@@ -132,10 +172,10 @@ CirPrintCmd::exec(const string& option)
       cirMgr->printPOs();
    else if (myStrNCmp("-FLoating", token, 3) == 0)
       cirMgr->printFloatGates();
-/*
+   else if (myStrNCmp("-MEMory", token, 4) == 0)
+      cirMgr->printMemory();
    else if (myStrNCmp("-FECpairs", token, 4) == 0)
       cirMgr->printFECPairs();
-*/
    else
       return CmdExec::errorOption(CMD_OPT_ILLEGAL, token);
 
@@ -145,10 +185,9 @@ CirPrintCmd::exec(const string& option)
 void
 CirPrintCmd::usage(ostream& os) const
 {  
-   os << "Usage: CIRPrint [-Summary | -Netlist | -PI | -PO | -FLoating]"
-      << endl;
-//   os << "Usage: CIRPrint [-Summary | -Netlist | -PI | -PO | -FLoating "
-//      << "| -FECpairs]" << endl;
+   os << "Usage: CIRPrint [-Summary | -Netlist | -PI | -PO | -FLoating "
+      << "| -MEMory\n"
+      << "                | -FECpairs]" << endl;
 }
 
 void
@@ -159,6 +198,7 @@ CirPrintCmd::help() const
 
 //----------------------------------------------------------------------
 //    CIRGate <<(int gateId)> [<-FANIn | -FANOut><(int level)>]>
+//            [-Output (string fileName)]
 //----------------------------------------------------------------------
 CmdExecStatus
 CirGateCmd::exec(const string& option)
@@ -178,10 +218,18 @@ CirGateCmd::exec(const string& option)
 
    int gateId = -1, level = 0;
    bool doFanin = false, doFanout = false;
-   CirGate* thisGate = 0;
+   bool thisGate = false;
+   string fileName;
    for (size_t i = 0, n = options.size(); i < n; ++i) {
       bool checkLevel = false;
-      if (myStrNCmp("-FANIn", options[i], 5) == 0) {
+      if (myStrNCmp("-Output", options[i], 2) == 0) {
+         if (fileName.size())
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i - 1]);
+         fileName = options[i];
+      }
+      else if (myStrNCmp("-FANIn", options[i], 5) == 0) {
          if (doFanin || doFanout)
             return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
          doFanin = true;
@@ -196,7 +244,7 @@ CirGateCmd::exec(const string& option)
       else if (!thisGate) {
          if (!myStr2Int(options[i], gateId) || gateId < 0)
             return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
-         thisGate = cirMgr->getGate(gateId);
+         thisGate = cirMgr->hasGate(gateId);
          if (!thisGate) {
             cerr << "Error: Gate(" << gateId << ") not found!!" << endl;
             return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[0]);
@@ -220,12 +268,20 @@ CirGateCmd::exec(const string& option)
       return CmdExec::errorOption(CMD_OPT_MISSING, options.back());
    }
 
+   // A large cone report can be streamed to a file
+   ofstream outfile;
+   if (fileName.size()) {
+      outfile.open(fileName.c_str());
+      if (!outfile)
+         return CmdExec::errorOption(CMD_OPT_FOPEN_FAIL, fileName);
+   }
+   ostream& os = fileName.size()? outfile: cout;
    if (doFanin)
-      thisGate->reportFanin(level);
+      cirMgr->reportFanin(gateId, level, os);
    else if (doFanout)
-      thisGate->reportFanout(level);
+      cirMgr->reportFanout(gateId, level, os);
    else
-      thisGate->reportGate();
+      cirMgr->reportGate(gateId, os);
 
    return CMD_EXEC_DONE;
 }
@@ -234,7 +290,8 @@ void
 CirGateCmd::usage(ostream& os) const
 {
    os << "Usage: CIRGate <<(int gateId)> [<-FANIn | -FANOut><(int level)>]>"
-      << endl;
+      << endl
+      << "               [-Output (string fileName)]" << endl;
 }
 
 void
@@ -245,7 +302,7 @@ CirGateCmd::help() const
 
 
 //----------------------------------------------------------------------
-//    CIRWrite [-Output (string aagFile)]
+//    CIRWrite [-Binary] [-Output (string aagFile)]
 //----------------------------------------------------------------------
 CmdExecStatus
 CirWriteCmd::exec(const string& option)
@@ -258,19 +315,38 @@ CirWriteCmd::exec(const string& option)
    vector<string> options;
    CmdExec::lexOptions(option, options);
 
-   if (options.empty())
-      cirMgr->writeAag(cout);
-   else if (myStrNCmp("-Output", options[0], 2) == 0) {
-      if (options.size() == 1)
-         return CmdExec::errorOption(CMD_OPT_MISSING, options[0]);
-      if (options.size() > 2)
-         return CmdExec::errorOption(CMD_OPT_EXTRA, options[2]);
-      ofstream outfile(options[1].c_str(), ios::out);
+   bool binary = false;
+   string fileName;
+   for (size_t i = 0, n = options.size(); i < n; ++i) {
+      if (myStrNCmp("-Binary", options[i], 2) == 0) {
+         if (binary) return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         binary = true;
+      }
+      else if (myStrNCmp("-Output", options[i], 2) == 0) {
+         if (fileName.size())
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i - 1]);
+         fileName = options[i];
+      }
+      else return CmdExec::errorOption(fileName.size()? CMD_OPT_EXTRA:
+                                       CMD_OPT_ILLEGAL, options[i]);
+   }
+
+   ofstream outfile;
+   if (fileName.size()) {
+      outfile.open(fileName.c_str(), binary? ios::out | ios::binary: ios::out);
       if (!outfile)
-         return CmdExec::errorOption(CMD_OPT_FOPEN_FAIL, options[1]);
-      cirMgr->writeAag(outfile);
+         return CmdExec::errorOption(CMD_OPT_FOPEN_FAIL, fileName);
+   }
+   ostream& os = fileName.size()? outfile: cout;
+   if (!binary)
+      cirMgr->writeAag(os);
+   else if (!cirMgr->writeAig(os)) {
+      cerr << "Error: floating gates cannot be written to a binary AIG file!!"
+           << endl;
+      return CMD_EXEC_ERROR;
    }
-   else return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[0]);
 
    return CMD_EXEC_DONE;
 }
@@ -278,13 +354,330 @@ CirWriteCmd::exec(const string& option)
 void
 CirWriteCmd::usage(ostream& os) const
 {
-   os << "Usage: CIRWrite [-Output (string aagFile)]" << endl;
+   os << "Usage: CIRWrite [-Binary] [-Output (string aagFile)]" << endl;
 }
 
 void
 CirWriteCmd::help() const
 {
    cout << setw(15) << left << "CIRWrite: "
-        << "write the netlist to an ASCII AIG file (.aag)\n";
+        << "write the netlist to an ASCII (.aag) or binary (.aig) AIG file\n";
 }
 
+
+//----------------------------------------------------------------------
+//    CIRSIMulate <-Random | -File <string patternFile> | -Bench>
+//                [-Output (string logFile)] [-Thread (int numThreads)]
+//----------------------------------------------------------------------
+CmdExecStatus
+CirSimCmd::exec(const string& option)
+{
+   if (!cirMgr) {
+      cerr << "Error: circuit is not yet constructed!!" << endl;
+      return CMD_EXEC_ERROR;
+   }
+   // check option
+   vector<string> options;
+   CmdExec::lexOptions(option, options);
+
+   ifstream patternFile;
+   ofstream logFile;
+   bool doRandom = false, doFile = false, doBench = false, doLog = false;
+   int numThreads = 0;
+   for (size_t i = 0, n = options.size(); i < n; ++i) {
+      if (myStrNCmp("-Random", options[i], 2) == 0) {
+         if (doRandom || doFile || doBench)
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         doRandom = true;
+      }
+      else if (myStrNCmp("-Bench", options[i], 2) == 0) {
+         if (doRandom || doFile || doBench)
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         doBench = true;
+      }
+      else if (myStrNCmp("-File", options[i], 2) == 0) {
+         if (doRandom || doFile || doBench)
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         patternFile.open(options[i].c_str(), ios::in);
+         if (!patternFile)
+            return CmdExec::errorOption(CMD_OPT_FOPEN_FAIL, options[i]);
+         doFile = true;
+      }
+      else if (myStrNCmp("-Output", options[i], 2) == 0) {
+         if (doLog)
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         logFile.open(options[i].c_str(), ios::out);
+         if (!logFile)
+            return CmdExec::errorOption(CMD_OPT_FOPEN_FAIL, options[i]);
+         doLog = true;
+      }
+      else if (myStrNCmp("-Thread", options[i], 2) == 0) {
+         if (numThreads)
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         if (!myStr2Int(options[i], numThreads) || numThreads <= 0)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+      }
+      else
+         return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+   }
+
+   if (!doRandom && !doFile && !doBench)
+      return CmdExec::errorOption(CMD_OPT_MISSING, "");
+   if (!checkNotCompact())
+      return CMD_EXEC_ERROR;
+
+   assert (curCmd != CIRINIT);
+   if (numThreads) cirMgr->setNumThreads(numThreads);
+   cirMgr->setSimLog(doLog? &logFile: 0);
+   if (doRandom)
+      cirMgr->randomSim();
+   else if (doBench)
+      cirMgr->benchSim();
+   else
+      cirMgr->fileSim(patternFile);
+   cirMgr->setSimLog(0);
+   curCmd = CIRSIMULATE;
+
+   return CMD_EXEC_DONE;
+}
+
+void
+CirSimCmd::usage(ostream& os) const
+{
+   os << "Usage: CIRSIMulate <-Random | -File <string patternFile> | -Bench>\n"
+      << "                   [-Output (string logFile)] "
+      << "[-Thread (int numThreads)]" << endl;
+}
+
+void
+CirSimCmd::help() const
+{
+   cout << setw(15) << left << "CIRSIMulate: "
+        << "perform Boolean logic simulation on the circuit\n";
+}
+
+//----------------------------------------------------------------------
+//    CIRSWeep
+//----------------------------------------------------------------------
+CmdExecStatus
+CirSweepCmd::exec(const string& option)
+{
+   if (!cirMgr) {
+      cerr << "Error: circuit is not yet constructed!!" << endl;
+      return CMD_EXEC_ERROR;
+   }
+   // check option
+   string token;
+   if (!CmdExec::lexSingleOption(option, token))
+      return CMD_EXEC_ERROR;
+   if (!token.empty())
+      return CmdExec::errorOption(CMD_OPT_EXTRA, token);
+   if (!checkNotCompact())
+      return CMD_EXEC_ERROR;
+
+   assert (curCmd != CIRINIT);
+   cirMgr->sweep();
+   curCmd = CIRSWEEP;
+
+   return CMD_EXEC_DONE;
+}
+
+void
+CirSweepCmd::usage(ostream& os) const
+{
+   os << "Usage: CIRSWeep" << endl;
+}
+
+void
+CirSweepCmd::help() const
+{
+   cout << setw(15) << left << "CIRSWeep: "
+        << "remove unused gates" << endl;
+}
+
+//----------------------------------------------------------------------
+//    CIROPTimize
+//----------------------------------------------------------------------
+CmdExecStatus
+CirOptCmd::exec(const string& option)
+{
+   if (!cirMgr) {
+      cerr << "Error: circuit is not yet constructed!!" << endl;
+      return CMD_EXEC_ERROR;
+   }
+   // check option
+   string token;
+   if (!CmdExec::lexSingleOption(option, token))
+      return CMD_EXEC_ERROR;
+   if (!token.empty())
+      return CmdExec::errorOption(CMD_OPT_EXTRA, token);
+   if (!checkNotCompact())
+      return CMD_EXEC_ERROR;
+
+   assert (curCmd != CIRINIT);
+   cirMgr->optimize();
+   curCmd = CIROPT;
+
+   return CMD_EXEC_DONE;
+}
+
+void
+CirOptCmd::usage(ostream& os) const
+{
+   os << "Usage: CIROPTimize" << endl;
+}
+
+void
+CirOptCmd::help() const
+{
+   cout << setw(15) << left << "CIROPTimize: "
+        << "perform trivial optimizations" << endl;
+}
+
+//----------------------------------------------------------------------
+//    CIRSTRash
+//----------------------------------------------------------------------
+CmdExecStatus
+CirStrashCmd::exec(const string& option)
+{
+   if (!cirMgr) {
+      cerr << "Error: circuit is not yet constructed!!" << endl;
+      return CMD_EXEC_ERROR;
+   }
+   // check option
+   string token;
+   if (!CmdExec::lexSingleOption(option, token))
+      return CMD_EXEC_ERROR;
+   if (!token.empty())
+      return CmdExec::errorOption(CMD_OPT_EXTRA, token);
+   if (!checkNotCompact())
+      return CMD_EXEC_ERROR;
+
+   assert (curCmd != CIRINIT);
+   cirMgr->strash();
+   curCmd = CIRSTRASH;
+
+   return CMD_EXEC_DONE;
+}
+
+void
+CirStrashCmd::usage(ostream& os) const
+{
+   os << "Usage: CIRSTRash" << endl;
+}
+
+void
+CirStrashCmd::help() const
+{
+   cout << setw(15) << left << "CIRSTRash: "
+        << "perform structural hash on the circuit netlist" << endl;
+}
+
+//----------------------------------------------------------------------
+//    CIRFraig
+//----------------------------------------------------------------------
+CmdExecStatus
+CirFraigCmd::exec(const string& option)
+{
+   if (!cirMgr) {
+      cerr << "Error: circuit is not yet constructed!!" << endl;
+      return CMD_EXEC_ERROR;
+   }
+   // check option
+   string token;
+   if (!CmdExec::lexSingleOption(option, token))
+      return CMD_EXEC_ERROR;
+   if (!token.empty())
+      return CmdExec::errorOption(CMD_OPT_EXTRA, token);
+   if (!checkNotCompact())
+      return CMD_EXEC_ERROR;
+
+   assert (curCmd != CIRINIT);
+   cirMgr->fraig();
+   curCmd = CIRFRAIG;
+
+   return CMD_EXEC_DONE;
+}
+
+void
+CirFraigCmd::usage(ostream& os) const
+{
+   os << "Usage: CIRFraig" << endl;
+}
+
+void
+CirFraigCmd::help() const
+{
+   cout << setw(15) << left << "CIRFraig: "
+        << "perform Boolean logic simplification on the circuit" << endl;
+}
+
+//----------------------------------------------------------------------
+//    CIREQuiv <(string fileName)> [-Output (string patternFile)]
+//----------------------------------------------------------------------
+CmdExecStatus
+CirEquivCmd::exec(const string& option)
+{
+   if (!cirMgr) {
+      cerr << "Error: circuit is not yet constructed!!" << endl;
+      return CMD_EXEC_ERROR;
+   }
+   // check option
+   vector<string> options;
+   if (!CmdExec::lexOptions(option, options))
+      return CMD_EXEC_ERROR;
+   if (options.empty())
+      return CmdExec::errorOption(CMD_OPT_MISSING, "");
+
+   string fileName;
+   ofstream patternFile;
+   bool doOutput = false;
+   for (size_t i = 0, n = options.size(); i < n; ++i) {
+      if (myStrNCmp("-Output", options[i], 2) == 0) {
+         if (doOutput)
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         patternFile.open(options[i].c_str(), ios::out);
+         if (!patternFile)
+            return CmdExec::errorOption(CMD_OPT_FOPEN_FAIL, options[i]);
+         doOutput = true;
+      }
+      else if (fileName.empty())
+         fileName = options[i];
+      else
+         return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+   }
+   if (fileName.empty())
+      return CmdExec::errorOption(CMD_OPT_MISSING, "");
+   if (!checkNotCompact())
+      return CMD_EXEC_ERROR;
+
+   assert (curCmd != CIRINIT);
+   CirMgr other;
+   if (!other.readCircuit(fileName))
+      return CMD_EXEC_ERROR;
+   cirMgr->checkEquiv(other, doOutput? &patternFile: 0);
+
+   return CMD_EXEC_DONE;
+}
+
+void
+CirEquivCmd::usage(ostream& os) const
+{
+   os << "Usage: CIREQuiv <(string fileName)> [-Output (string patternFile)]"
+      << endl;
+}
+
+void
+CirEquivCmd::help() const
+{
+   cout << setw(15) << left << "CIREQuiv: "
+        << "check the equivalence of the circuit with another one" << endl;
+}
@@ -15,5 +15,11 @@ CmdClass(CirReadCmd);
 CmdClass(CirPrintCmd);
 CmdClass(CirGateCmd);
 CmdClass(CirWriteCmd);
+CmdClass(CirSimCmd);
+CmdClass(CirSweepCmd);
+CmdClass(CirOptCmd);
+CmdClass(CirStrashCmd);
+CmdClass(CirFraigCmd);
+CmdClass(CirEquivCmd);
 
 #endif // CIR_CMD_H
@@ -0,0 +1,352 @@
+/****************************************************************************
+  FileName     [ cirCompact.cpp ]
+  PackageName  [ cir ]
+  Synopsis     [ Define the compact (struct-of-arrays) circuit storage ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <cassert>
+#include <cstring>
+#include <algorithm>
+#include "cirCompact.h"
+#include "cirGate.h"
+
+using namespace std;
+
+/*************************************/
+/*   class CirCompact construction   */
+/*************************************/
+CirCompact::CirCompact(CirGate* const* gates, unsigned maxId,
+                       const GateList& pis, const GateList& pos,
+                       const IdList& flt, const IdList& unused)
+: _type(maxId, UNDEF_GATE), _fanin(2 * size_t(maxId), 0), _lineNo(maxId, 0),
+  _foutBegin(size_t(maxId) + 1, 0), _numAIGs(0), _float(flt), _unused(unused),
+  _reportStamp(0)
+{
+   size_t numFanouts = 0;
+   for (unsigned i = 0; i < maxId; ++i)
+      if (gates[i]) numFanouts += gates[i]->getFanoutPinSize();
+   _fanout.reserve(numFanouts);
+   for (unsigned i = 0; i < maxId; ++i) {
+      _foutBegin[i] = _fanout.size();
+      const CirGate* g = gates[i];
+      if (!g) continue;
+      _type[i] = g->getType();
+      _lineNo[i] = g->getLineNo();
+      if (_type[i] == AIG_GATE) ++_numAIGs;
+      for (unsigned j = 0; j < g->getFaninIdSize(); ++j)
+         _fanin[2 * i + j] = g->getFaninId(j);
+      for (unsigned j = 0; j < g->getFanoutPinSize(); ++j) {
+         pin p = g->getFanoutPin(j);
+         _fanout.push_back(p.gate()->getId() * 2 + p.isInv());
+      }
+      if (g->getSymbol() != "") {
+         string s = g->getSymbol();
+         _symbols.push_back(make_pair(uint32_t(i), uint32_t(_symNames.size())));
+         _symNames.insert(_symNames.end(), s.c_str(), s.c_str() + s.size() + 1);
+      }
+   }
+   _foutBegin[maxId] = _fanout.size();
+   _symNames.shrink_to_fit();
+   _symbols.shrink_to_fit();
+   _PIs.reserve(pis.size());
+   for (size_t i = 0; i < pis.size(); ++i) _PIs.push_back(pis[i]->getId());
+   _POs.reserve(pos.size());
+   for (size_t i = 0; i < pos.size(); ++i) _POs.push_back(pos[i]->getId());
+}
+
+size_t
+CirCompact::getMemUsage() const
+{
+   return sizeof(*this) + _type.capacity() * sizeof(uint8_t)
+      + (_fanin.capacity() + _lineNo.capacity() + _foutBegin.capacity()
+         + _fanout.capacity()) * sizeof(uint32_t)
+      + _symbols.capacity() * sizeof(pair<uint32_t, uint32_t>)
+      + _symNames.capacity()
+      + (_PIs.capacity() + _POs.capacity() + _float.capacity()
+         + _unused.capacity() + _reportRef.capacity()) * sizeof(unsigned);
+}
+
+const char*
+CirCompact::getTypeStr(unsigned gid) const
+{
+   switch (_type[gid]) {
+      case PI_GATE: return "PI";
+      case PO_GATE: return "PO";
+      case AIG_GATE: return "AIG";
+      case CONST_GATE: return "CONST";
+      default: return "UNDEF";
+   }
+}
+
+// Return 0 if 'gid' has no symbol
+const char*
+CirCompact::getSymbol(unsigned gid) const
+{
+   vector<pair<uint32_t, uint32_t> >::const_iterator it = lower_bound(
+      _symbols.begin(), _symbols.end(), make_pair(uint32_t(gid), uint32_t(0)));
+   if (it == _symbols.end() || it->first != gid) return 0;
+   return &_symNames[it->second];
+}
+
+/*************************************/
+/*   class CirCompact printing       */
+/*************************************/
+// All the gates in the DFS post-order from the POs, as in the netlist
+void
+CirCompact::dfsOrder(IdList& order) const
+{
+   vector<bool> ref(_type.size(), false);
+   vector<pair<unsigned, unsigned> > stack;  // (ID, next fanin)
+   for (size_t i = 0; i < _POs.size(); ++i) {
+      stack.push_back(make_pair(_POs[i], 0u));
+      while (!stack.empty()) {
+         pair<unsigned, unsigned>& top = stack.back();
+         if (top.second < getNumFanins(top.first)) {
+            unsigned f = _fanin[2 * top.first + top.second++] / 2;
+            if (hasGate(f) && !ref[f]) {
+               ref[f] = true;
+               stack.push_back(make_pair(f, 0u));
+            }
+         }
+         else {
+            order.push_back(top.first);
+            stack.pop_back();
+         }
+      }
+   }
+}
+
+void
+CirCompact::printSummary() const
+{
+   cout << endl;
+   cout << "Circuit Statistics" << endl;
+   cout << "==================" << endl;
+   cout << "  PI   " << setw(9) << right << _PIs.size() << endl;
+   cout << "  PO   " << setw(9) << right << _POs.size() << endl;
+   cout << "  AIG  " << setw(9) << right << _numAIGs << endl;
+   cout << "------------------" << endl;
+   cout << "  Total" << setw(9) << getNumGates() << right << endl;
+}
+
+void
+CirCompact::printNetlist() const
+{
+   cout << endl;
+   IdList order;
+   dfsOrder(order);
+   for (size_t i = 0; i < order.size(); ++i) {
+      unsigned g = order[i];
+      cout << "[" << i << "] " << setw(4) << left << getTypeStr(g) << g;
+      for (unsigned j = 0; j < getNumFanins(g); ++j) {
+         unsigned lit = _fanin[2 * g + j];
+         cout << " ";
+         if (!hasGate(lit / 2)) cout << "*";
+         if (lit % 2) cout << "!";
+         cout << lit / 2;
+      }
+      if (getSymbol(g)) cout << " (" << getSymbol(g) << ")";
+      cout << endl;
+   }
+}
+
+void
+CirCompact::printPIs() const
+{
+   cout << "PIs of the circuit:";
+   for (size_t i = 0; i < _PIs.size(); ++i)
+      cout << " " << _PIs[i];
+   cout << endl;
+}
+
+void
+CirCompact::printPOs() const
+{
+   cout << "POs of the circuit:";
+   for (size_t i = 0; i < _POs.size(); ++i)
+      cout << " " << _POs[i];
+   cout << endl;
+}
+
+void
+CirCompact::printFloatGates() const
+{
+   if (_float.size()) {
+      cout << "Gates with floating fanin(s):";
+      for (size_t i = 0; i < _float.size(); ++i)
+         cout << " " << _float[i];
+      cout << endl;
+   }
+   if (_unused.size()) {
+      cout << "Gates defined but not used  :";
+      for (size_t i = 0; i < _unused.size(); ++i)
+         cout << " " << _unused[i];
+      cout << endl;
+   }
+}
+
+void
+CirCompact::writeAag(ostream& outfile) const
+{
+   IdList order, aigs;
+   dfsOrder(order);
+   // As in CirMgr::writeAag(), an added AIG may have an ID above the POs
+   unsigned m = _type.size() - _POs.size() - 1;
+   for (size_t i = 0; i < order.size(); ++i)
+      if (_type[order[i]] == AIG_GATE) {
+         aigs.push_back(order[i]);
+         m = max(m, order[i]);
+      }
+   outfile << "aag " << m << " " << _PIs.size()
+           << " 0 " << _POs.size() << " " << aigs.size() << endl;
+   for (size_t i = 0; i < _PIs.size(); ++i)
+      outfile << _PIs[i] * 2 << endl;
+   for (size_t i = 0; i < _POs.size(); ++i)
+      outfile << _fanin[2 * _POs[i]] << endl;
+   for (size_t i = 0; i < aigs.size(); ++i)
+      outfile << aigs[i] * 2 << " " << _fanin[2 * aigs[i]] << " "
+              << _fanin[2 * aigs[i] + 1] << endl;
+   for (size_t i = 0; i < _PIs.size(); ++i)
+      if (getSymbol(_PIs[i]))
+         outfile << "i" << i << " " << getSymbol(_PIs[i]) << endl;
+   for (size_t i = 0; i < _POs.size(); ++i)
+      if (getSymbol(_POs[i]))
+         outfile << "o" << i << " " << getSymbol(_POs[i]) << endl;
+   outfile << "c" << endl;
+   outfile << "finally it comes to an end (TAT)" << endl;
+}
+
+static inline void
+writeDelta(ostream& os, unsigned n)
+{
+   for (; n & ~0x7fu; n >>= 7)
+      os.put(char((n & 0x7f) | 0x80));
+   os.put(char(n));
+}
+
+// As CirMgr::writeAig()
+bool
+CirCompact::writeAig(ostream& outfile) const
+{
+   IdList order, aigs;
+   dfsOrder(order);
+   for (size_t i = 0; i < order.size(); ++i) {
+      unsigned g = order[i];
+      for (unsigned j = 0; j < getNumFanins(g); ++j)
+         if (!hasGate(_fanin[2 * g + j] / 2)) return false;
+      if (_type[g] == AIG_GATE) aigs.push_back(g);
+   }
+   IdList newId(_type.size(), 0);
+   for (size_t i = 0; i < _PIs.size(); ++i)
+      newId[_PIs[i]] = i + 1;
+   for (size_t i = 0; i < aigs.size(); ++i)
+      newId[aigs[i]] = _PIs.size() + i + 1;
+
+   outfile << "aig " << _PIs.size() + aigs.size() << " " << _PIs.size()
+           << " 0 " << _POs.size() << " " << aigs.size() << "\n";
+   for (size_t i = 0; i < _POs.size(); ++i) {
+      unsigned lit = _fanin[2 * _POs[i]];
+      outfile << newId[lit / 2] * 2 + lit % 2 << "\n";
+   }
+   for (size_t i = 0; i < aigs.size(); ++i) {
+      unsigned lhs = newId[aigs[i]] * 2;
+      unsigned lit0 = _fanin[2 * aigs[i]], lit1 = _fanin[2 * aigs[i] + 1];
+      unsigned rhs0 = newId[lit0 / 2] * 2 + lit0 % 2;
+      unsigned rhs1 = newId[lit1 / 2] * 2 + lit1 % 2;
+      if (rhs0 < rhs1) swap(rhs0, rhs1);
+      writeDelta(outfile, lhs - rhs0);
+      writeDelta(outfile, rhs0 - rhs1);
+   }
+   for (size_t i = 0; i < _PIs.size(); ++i)
+      if (getSymbol(_PIs[i]))
+         outfile << "i" << i << " " << getSymbol(_PIs[i]) << "\n";
+   for (size_t i = 0; i < _POs.size(); ++i)
+      if (getSymbol(_POs[i]))
+         outfile << "o" << i << " " << getSymbol(_POs[i]) << "\n";
+   outfile << "c" << "\n";
+   outfile << "finally it comes to an end (TAT)" << endl;
+   return true;
+}
+
+void
+CirCompact::reportGate(unsigned gid, ostream& os) const
+{
+   os << "==================================================" << endl;
+   stringstream ss;
+   string report;
+   ss << "= " << getTypeStr(gid) << "(" << gid << ")";
+   if (getSymbol(gid))
+      ss << "\"" << getSymbol(gid) << "\"";
+   ss << ", line " << _lineNo[gid];
+   getline(ss, report);
+   os << setw(49) << left << report << "=" << endl;
+   os << "==================================================" << endl;
+}
+
+void
+CirCompact::reportFanin(unsigned gid, int level, ostream& os) const
+{
+   reportCone(gid, level, true, os);
+}
+
+void
+CirCompact::reportFanout(unsigned gid, int level, ostream& os) const
+{
+   reportCone(gid, level, false, os);
+}
+
+// As CirGate::reportCone(), with the stamps in _reportRef for the global
+// ref; they are kept between the calls and cleared only on a wrap-around
+void
+CirCompact::reportCone(unsigned gid, int level, bool fanin,
+                       ostream& os) const
+{
+   assert(level >= 0);
+   if (_reportRef.size() != _type.size())
+      _reportRef.assign(_type.size(), 0);
+   if (++_reportStamp == 0) {
+      fill(_reportRef.begin(), _reportRef.end(), 0);
+      _reportStamp = 1;
+   }
+   vector<pair<unsigned, unsigned> > stack;
+   string indent;
+   os << getTypeStr(gid) << " " << gid << '\n';
+   if (level > 0)
+      stack.push_back(make_pair(gid, 0u));
+   while (!stack.empty()) {
+      unsigned g = stack.back().first;
+      unsigned i = stack.back().second++;
+      unsigned n = fanin? getNumFanins(g): _foutBegin[g + 1] - _foutBegin[g];
+      if (i == n) {
+         stack.pop_back();
+         continue;
+      }
+      size_t depth = stack.size();
+      unsigned lit = fanin? _fanin[2 * g + i]: _fanout[_foutBegin[g + 1] - 1 - i];
+      if (indent.size() < 2 * depth)
+         indent.resize(2 * depth, ' ');
+      os.write(indent.data(), 2 * depth);
+      if (lit % 2)
+         os << "!";
+      if (!hasGate(lit / 2)) {   // Floating gate
+         os << "UNDEF " << lit / 2 << '\n';
+         continue;
+      }
+      os << getTypeStr(lit / 2) << " " << lit / 2;
+      if (depth < size_t(level)) {
+         if (_reportRef[lit / 2] != _reportStamp) {
+            _reportRef[lit / 2] = _reportStamp;
+            stack.push_back(make_pair(lit / 2, 0u));
+         }
+         else if (_type[lit / 2] == AIG_GATE)
+            os << " (*)";
+      }
+      os << '\n';
+   }
+   os.flush();
+}
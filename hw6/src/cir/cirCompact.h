@@ -0,0 +1,83 @@
+/****************************************************************************
+  FileName     [ cirCompact.h ]
+  PackageName  [ cir ]
+  Synopsis     [ Define the compact (struct-of-arrays) circuit storage ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#ifndef CIR_COMPACT_H
+#define CIR_COMPACT_H
+
+#include <vector>
+#include <string>
+#include <iostream>
+#include <stdint.h>
+#include "cirDef.h"
+
+using namespace std;
+
+//------------------------------------------------------------------------
+//   class CirCompact
+//------------------------------------------------------------------------
+// The circuit without CirGate objects: every array is indexed by gate
+// ID, and a fanin or fanout is a literal (ID * 2 + inverted).
+// - _type      : GateType of each ID (UNDEF_GATE if not defined)
+// - _fanin     : the 2 fanin literals of ID at [2 * ID] and [2 * ID + 1]
+// - _foutBegin : the fanouts of ID are _fanout[_foutBegin[ID] ..
+//                _foutBegin[ID + 1]), in the order of CirGate
+// - symbols    : (ID, offset in _symNames) sorted by ID
+// It supports the reporting and writing commands only.
+//
+class CirCompact
+{
+public:
+   // Copy the circuit of 'gates' [0, maxId)
+   CirCompact(CirGate* const* gates, unsigned maxId, const GateList& pis,
+              const GateList& pos, const IdList& flt, const IdList& unused);
+   ~CirCompact() {}
+
+   bool hasGate(unsigned gid) const {
+      return gid < _type.size() && _type[gid] != UNDEF_GATE; }
+   // #Bytes of all the arrays
+   size_t getMemUsage() const;
+   size_t getNumGates() const { return _PIs.size() + _POs.size() + _numAIGs; }
+
+   // Printing functions, as those of CirMgr and CirGate
+   void printSummary() const;
+   void printNetlist() const;
+   void printPIs() const;
+   void printPOs() const;
+   void printFloatGates() const;
+   void writeAag(ostream&) const;
+   bool writeAig(ostream&) const;
+   void reportGate(unsigned gid, ostream&) const;
+   void reportFanin(unsigned gid, int level, ostream&) const;
+   void reportFanout(unsigned gid, int level, ostream&) const;
+
+private:
+   vector<uint8_t>      _type;
+   vector<uint32_t>     _fanin;
+   vector<uint32_t>     _lineNo;
+   vector<uint32_t>     _foutBegin;
+   vector<uint32_t>     _fanout;
+   vector<pair<uint32_t, uint32_t> >  _symbols;
+   vector<char>         _symNames;
+   IdList               _PIs;
+   IdList               _POs;
+   size_t               _numAIGs;
+   IdList               _float;
+   IdList               _unused;
+   // Visited stamps of reportCone(), by ID
+   mutable IdList       _reportRef;
+   mutable unsigned     _reportStamp;
+
+   unsigned getNumFanins(unsigned gid) const {
+      return (_type[gid] == AIG_GATE)? 2: (_type[gid] == PO_GATE)? 1: 0; }
+   const char* getTypeStr(unsigned gid) const;
+   const char* getSymbol(unsigned gid) const;
+   void dfsOrder(IdList& order) const;
+   void reportCone(unsigned gid, int level, bool fanin, ostream&) const;
+};
+
+#endif // CIR_COMPACT_H
@@ -0,0 +1,409 @@
+/****************************************************************************
+  FileName     [ cirFraig.cpp ]
+  PackageName  [ cir ]
+  Synopsis     [ Define cir FRAIG functions ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2012-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#include <iostream>
+#include <iomanip>
+#include <map>
+#include <chrono>
+#include <cassert>
+#include "cirMgr.h"
+#include "cirGate.h"
+#include "cirSat.h"
+#include "util.h"
+
+using namespace std;
+
+/**************************************/
+/*   Static variables and functions   */
+/**************************************/
+// A FEC pair not proved or disproved within this many conflicts is
+// given up (and not merged)
+static const size_t FRAIG_CONFLICTS = 10000;
+// checkEquiv(): #rounds of random blocks simulated before and after
+// strash, and the conflicts allowed for each PO left after fraig
+static const size_t CEC_SIM_ROUNDS = 8;
+static const size_t CEC_CONFLICTS = 1000000;
+// Slot without a solver variable (see CirMgr::satVar())
+static const unsigned NO_SAT_VAR = ~0u;
+
+// Pair each gate of 'g2' with an index of 'g1', by the symbols if they
+// all have distinct ones that match, otherwise by order
+static bool
+matchPorts(const GateList& g1, const GateList& g2, IdList& to1,
+           const string& what)
+{
+   if (g1.size() != g2.size()) {
+      cerr << "Error: the numbers of " << what << "s are different ("
+           << g1.size() << " vs. " << g2.size() << ")!!" << endl;
+      return false;
+   }
+   to1.resize(g2.size());
+   map<string, unsigned> index;
+   bool named = true;
+   for (size_t i = 0; named && i < g1.size(); ++i) {
+      string s = g1[i]->getSymbol();
+      named = !s.empty() && index.insert(make_pair(s, i)).second;
+   }
+   for (size_t i = 0; named && i < g2.size(); ++i) {
+      map<string, unsigned>::iterator it = index.find(g2[i]->getSymbol());
+      named = (it != index.end());
+      if (named) {
+         to1[i] = it->second;
+         index.erase(it);
+      }
+   }
+   if (!named)
+      for (size_t i = 0; i < g2.size(); ++i)
+         to1[i] = i;
+   return true;
+}
+
+// Open-addressing (linear probing) table from the fanin literals of an
+// AIG, smaller one in the upper half, to the AIG
+class StrashTable
+{
+public:
+   // Room for 'n' keys at a load factor of at most 1/2
+   StrashTable(size_t n) : _bits(1) {
+      while ((size_t(1) << _bits) < 2 * n) ++_bits;
+      _keys.assign(size_t(1) << _bits, EMPTY);
+      _gates.resize(size_t(1) << _bits);
+   }
+
+   static uint64_t key(unsigned lit0, unsigned lit1) {
+      if (lit0 > lit1) swap(lit0, lit1);
+      return (uint64_t(lit0) << 32) | lit1;
+   }
+   // Return the AIG of key 'k' if any; otherwise add 'g' with it and
+   // return 0
+   CirGate* insert(uint64_t k, CirGate* g) {
+      size_t mask = _keys.size() - 1;
+      for (size_t i = (k * 0x9e3779b97f4a7c15ULL) >> (64 - _bits); ;
+           i = (i + 1) & mask) {
+         if (_keys[i] == k) return _gates[i];
+         if (_keys[i] == EMPTY) {
+            _keys[i] = k; _gates[i] = g;
+            return 0;
+         }
+      }
+   }
+
+private:
+   // Not a key: the literals are below 2^32 - 1
+   static const uint64_t EMPTY = ~uint64_t(0);
+
+   unsigned             _bits;
+   vector<uint64_t>     _keys;
+   GateList             _gates;
+};
+
+const uint64_t StrashTable::EMPTY;
+
+/*******************************************/
+/*   Public member functions about fraig   */
+/*******************************************/
+// Go through the AIGs in DFS order, so the fanins of an AIG have been
+// merged before it is looked up; merge it into the first AIG with the
+// same fanins
+void
+CirMgr::strash()
+{
+   chrono::steady_clock::time_point start = chrono::steady_clock::now();
+   flushDeleted();
+   // Built again when next needed, as keeping them costs more over a pass
+   invalidateLevels();
+   _batchEdits = true;
+   // A copy, as replaceGate() moves gates in the DFS order
+   GateList dfsList(getDfsList());
+   StrashTable table(_AIGs.size());
+   size_t numMerged = 0;
+   for (size_t n = 0; n < dfsList.size(); ++n) {
+      CirGate* g = dfsList[n];
+      if (g->getType() != AIG_GATE) continue;
+      CirGate* r = table.insert(StrashTable::key(g->getFaninId(0),
+                                                 g->getFaninId(1)), g);
+      if (r && replaceGate(g->getId(), r->getId() * 2)) ++numMerged;
+   }
+   flushDeleted();
+   chrono::duration<double> d = chrono::steady_clock::now() - start;
+   cout << "Strashing: " << numMerged << " AIG(s) merged in "
+        << setprecision(4) << d.count() << " seconds" << endl;
+}
+
+// Prove each member of a FEC group against the first one, which has the
+// lowest slot and is thus never in the fanout cone of the others. One
+// solver holds the CNF of the cones encoded so far, and each pair is a
+// call under the assumption that their XOR is 1; a proved pair is
+// merged and its equivalence kept as a clause. The counter-examples of
+// the pairs that differ are simulated, SIM_PATTERNS at a time, to split
+// the groups before going on.
+void
+CirMgr::fraig()
+{
+   if (!_fecInit) {
+      cerr << "Error: circuit has not been simulated; no FEC pairs to prove!!"
+           << endl;
+      return;
+   }
+   chrono::steady_clock::time_point start = chrono::steady_clock::now();
+   flushDeleted();
+   // Built again when next needed, as keeping them costs more over a pass
+   invalidateLevels();
+   size_t numAIGs = _AIGs.size(), numPIs = _PIs.size();
+   size_t numProved = 0, numCex = 0, numUnknown = 0;
+   SatSolver solver;
+   IdList slotVar;
+   initSatVars(solver, slotVar);
+   vector<pair<unsigned, unsigned> > merges;   // (member, first) literals
+   vector<uint64_t> piValue(numPIs * SIM_WORDS, 0);
+   size_t k = 0;   // #counter-examples in piValue
+   while (!_fecGrps.empty()) {
+      for (size_t g = 0; g < _fecGrps.size(); ++g) {
+         IdList& grp = _fecGrps[g];
+         size_t n = 1;
+         for (size_t i = 1; i < grp.size(); ++i) {
+            if (k == SIM_PATTERNS) { grp[n++] = grp[i]; continue; }
+            Var a = satVar(solver, slotVar, grp[0] / 2);
+            Var b = satVar(solver, slotVar, grp[i] / 2);
+            Var d = solver.newVar();
+            solver.addXorCNF(d, a, false, b, (grp[0] ^ grp[i]) & 1);
+            solver.assumeRelease();
+            solver.assumeProperty(d, true);
+            SatSolver::Result res = solver.assumpSolve(FRAIG_CONFLICTS);
+            if (res == SatSolver::UNSAT) {
+               merges.push_back(make_pair(grp[i], grp[0]));
+               solver.addClause(IdList(1, d * 2 + 1));
+               ++numProved;
+            }
+            else if (res == SatSolver::SAT) {
+               for (size_t p = 0; p < numPIs; ++p)
+                  if (solver.getValue(slotVar[1 + p]))
+                     piValue[p * SIM_WORDS + k / 64] |= uint64_t(1) << (k % 64);
+               ++k; ++numCex;
+               grp[n++] = grp[i];
+            }
+            else ++numUnknown;
+         }
+         grp.resize(n);
+      }
+      size_t n = 0;
+      for (size_t g = 0; g < _fecGrps.size(); ++g)
+         if (_fecGrps[g].size() > 1) _fecGrps[n++].swap(_fecGrps[g]);
+      _fecGrps.resize(n);
+      if (k) {
+         simBlocks(piValue, 1, k, SIM_BLOCKS, 1);
+         fill(piValue.begin(), piValue.end(), uint64_t(0));
+         k = 0;
+      }
+   }
+
+   // Map the slots to gate IDs first, as replaceGate() drops the
+   // simulation program
+   IdList gids, lits;
+   for (size_t i = 0; i < merges.size(); ++i) {
+      unsigned r = merges[i].second < 2? 0: _simIds[merges[i].second / 2];
+      gids.push_back(_simIds[merges[i].first / 2]);
+      lits.push_back(r * 2 + ((merges[i].first ^ merges[i].second) & 1));
+   }
+   size_t numMerged = 0;
+   _batchEdits = true;
+   for (size_t i = 0; i < gids.size(); ++i)
+      if (replaceGate(gids[i], lits[i])) ++numMerged;
+   flushDeleted();
+   chrono::duration<double> d = chrono::steady_clock::now() - start;
+   cout << "Fraig: " << numMerged << " AIG(s) merged (" << numProved
+        << " proved, " << numCex << " counter-example(s), " << numUnknown
+        << " undecided), AIGs " << numAIGs << " -> " << _AIGs.size()
+        << ", in " << setprecision(4) << d.count() << " seconds" << endl;
+}
+
+/**********************************************************/
+/*   Public member functions about equivalence checking   */
+/**********************************************************/
+// Build a miter with a PO for each pair of POs that is 1 where they
+// differ. Random simulation looks for cheap counter-examples first; if
+// there are none, the miter is strashed and fraiged, and each PO not
+// merged into CONST0 by then is solved on its own.
+void
+CirMgr::checkEquiv(const CirMgr& other, ostream* patternFile) const
+{
+   chrono::steady_clock::time_point start = chrono::steady_clock::now();
+   IdList piMap, poMap;
+   if (!matchPorts(_PIs, other._PIs, piMap, "PI") ||
+       !matchPorts(_POs, other._POs, poMap, "PO"))
+      return;
+   CirMgr miter;
+   miter.setNumThreads(_numThreads);
+   miter.buildMiter(*this, other, piMap, poMap);
+   size_t numPIs = _PIs.size(), numPOs = _POs.size();
+   size_t numProved = 0, numDiff = 0, numUnknown = 0;
+   vector<string> cex;
+   miter.randomSimPo(CEC_SIM_ROUNDS, cex);
+   for (size_t i = 0; i < numPOs; ++i)
+      if (!cex[i].empty()) ++numDiff;
+   if (!numDiff) {
+      miter.strash();
+      miter.randomSimPo(CEC_SIM_ROUNDS, cex);
+      miter.fraig();
+      miter.buildSimProg();
+      SatSolver solver;
+      IdList slotVar;
+      miter.initSatVars(solver, slotVar);
+      for (size_t i = 0; i < numPOs; ++i) {
+         unsigned lit = miter._simPo[i];
+         if (lit == 0) { ++numProved; continue; }
+         // The PO is 1 iff v != (lit & 1); slot 0 is the CONST0 variable
+         Var v = miter.satVar(solver, slotVar, lit / 2);
+         solver.assumeRelease();
+         solver.assumeProperty(v, !(lit & 1));
+         SatSolver::Result res = solver.assumpSolve(CEC_CONFLICTS);
+         if (res == SatSolver::UNSAT) {
+            ++numProved;
+            // The PO is 0: keep it for the next POs
+            solver.addClause(IdList(1, v * 2 + ((lit & 1) ^ 1)));
+         }
+         else if (res == SatSolver::SAT) {
+            ++numDiff;
+            cex[i].assign(numPIs, '0');
+            for (size_t p = 0; p < numPIs; ++p)
+               if (solver.getValue(slotVar[1 + p])) cex[i][p] = '1';
+         }
+         else ++numUnknown;
+      }
+   }
+
+   for (size_t i = 0; i < numPOs; ++i) {
+      if (cex[i].empty()) continue;
+      if (patternFile)
+         *patternFile << cex[i] << endl;
+      else
+         cout << "PO " << _POs[i]->getId() << " differs on " << cex[i] << endl;
+   }
+   chrono::duration<double> d = chrono::steady_clock::now() - start;
+   if (numDiff)
+      cout << "Circuits are NOT equivalent: " << numDiff
+           << " PO pair(s) differ";
+   else if (numUnknown)
+      cout << "Equivalence is undecided: " << numUnknown
+           << " PO pair(s) not proved";
+   else
+      cout << "Circuits are equivalent: " << numProved
+           << " PO pair(s) proved";
+   cout << ", in " << setprecision(4) << d.count() << " seconds" << endl;
+}
+
+/********************************************/
+/*   Private member functions about fraig   */
+/********************************************/
+// Build the miter of 'c1' and 'c2' in this empty circuit: PI j of 'c1'
+// and PI piMap[j] of 'c2' are PI j + 1, the reachable AIGs of each
+// follow in DFS order, and PO j is the XOR of PO j of 'c1' and the PO of
+// 'c2' paired with it by poMap (CONST0 if the literals are the same). A
+// floating fanin is CONST0, as in the simulation.
+void
+CirMgr::buildMiter(const CirMgr& c1, const CirMgr& c2, const IdList& piMap,
+                   const IdList& poMap)
+{
+   size_t numPIs = c1._PIs.size(), numPOs = c1._POs.size();
+   IdList fanins;   // 2 literals for each AIG
+   unsigned next = numPIs + 1;
+   auto addAig = [&](unsigned a, unsigned b) {
+      fanins.push_back(a);
+      fanins.push_back(b);
+      return 2 * next++;
+   };
+   IdList out[2];
+   for (size_t k = 0; k < 2; ++k) {
+      const CirMgr& c = k? c2: c1;
+      IdList lit(c._maxId, 0);
+      for (size_t j = 0; j < numPIs; ++j)
+         lit[c._PIs[j]->getId()] = 2 * (1 + (k? piMap[j]: j));
+      const GateList& dfsList = c.getDfsList();
+      for (size_t n = 0; n < dfsList.size(); ++n) {
+         const CirGate* g = dfsList[n];
+         if (g->getType() != AIG_GATE) continue;
+         unsigned a = g->getFaninId(0), b = g->getFaninId(1);
+         lit[g->getId()] = addAig(lit[a / 2] ^ (a & 1), lit[b / 2] ^ (b & 1));
+      }
+      out[k].resize(numPOs);
+      for (size_t j = 0; j < numPOs; ++j) {
+         unsigned a = c._POs[j]->getFaninId(0);
+         out[k][j] = lit[a / 2] ^ (a & 1);
+      }
+   }
+   IdList poLit(numPOs, 0);
+   for (size_t j = 0; j < numPOs; ++j) {
+      unsigned x = out[0][poMap[j]], y = out[1][j];
+      if (x == y) continue;
+      // x ^ y = !(!(x & !y) & !(!x & y))
+      unsigned t0 = addAig(x, y ^ 1), t1 = addAig(x ^ 1, y);
+      poLit[poMap[j]] = addAig(t0 ^ 1, t1 ^ 1) ^ 1;
+   }
+
+   size_t numAIGs = fanins.size() / 2, m = numPIs + numAIGs;
+   _maxId = m + numPOs + 1;
+   _gates = _arena.allocArr<CirGate*>(_maxId);
+   fill(_gates, _gates + _maxId, (CirGate*)0);
+   _gates[0] = _const;
+   for (size_t j = 0; j < numPIs; ++j) {
+      _PIs.push_back(_gatePool.create<PI>(0, 1 + j));
+      _gates[1 + j] = _PIs.back();
+   }
+   for (size_t j = 0; j < numAIGs; ++j) {
+      CirGate* g = _gatePool.create<AIG>(0, numPIs + 1 + j);
+      g->addFaninId(fanins[2 * j]);
+      g->addFaninId(fanins[2 * j + 1]);
+      _AIGs.push_back(g);
+      _gates[numPIs + 1 + j] = g;
+   }
+   for (size_t j = 0; j < numPOs; ++j) {
+      CirGate* g = _gatePool.create<PO>(0, m + 1 + j);
+      g->addFaninId(poLit[j]);
+      _POs.push_back(g);
+      _gates[m + 1 + j] = g;
+   }
+   connectCircuit();
+}
+
+// Map the slots of the simulation program to solver variables, none
+// yet but CONST0
+void
+CirMgr::initSatVars(SatSolver& solver, IdList& slotVar) const
+{
+   slotVar.assign(_simIds.size(), NO_SAT_VAR);
+   slotVar[0] = solver.newVar();
+   solver.addClause(IdList(1, slotVar[0] * 2 + 1));
+}
+
+// Tseitin encoding of the cone of 'slot', by the fanin slots of the
+// AIGs (a floating fanin is CONST0, as in the simulation); the AIGs
+// already encoded are shared
+unsigned
+CirMgr::satVar(SatSolver& solver, IdList& slotVar, unsigned slot) const
+{
+   size_t numPIs = _PIs.size();
+   IdList stack(1, slot);
+   while (!stack.empty()) {
+      unsigned t = stack.back();
+      if (slotVar[t] != NO_SAT_VAR) { stack.pop_back(); continue; }
+      if (t <= numPIs) {
+         slotVar[t] = solver.newVar();
+         stack.pop_back();
+         continue;
+      }
+      const unsigned* f = &_simFanin[2 * (t - 1 - numPIs)];
+      if (slotVar[f[0] / 2] == NO_SAT_VAR) stack.push_back(f[0] / 2);
+      if (slotVar[f[1] / 2] == NO_SAT_VAR) stack.push_back(f[1] / 2);
+      if (stack.back() != t) continue;
+      slotVar[t] = solver.newVar();
+      solver.addAigCNF(slotVar[t], slotVar[f[0] / 2], f[0] & 1,
+                       slotVar[f[1] / 2], f[1] & 1);
+      stack.pop_back();
+   }
+   return slotVar[slot];
+}
@@ -25,9 +25,9 @@ extern CirMgr *cirMgr;
 /*   class CirGate member functions   */
 /**************************************/
 void
-CirGate::reportGate() const
+CirGate::reportGate(ostream& os) const
 {
-  	cout << "==================================================" << endl;
+  	os << "==================================================" << endl;
   	stringstream ss;
   	string report;
   	ss << "= " << getTypeStr() << "(" << getId() << ")" ;
@@ -35,88 +35,74 @@ CirGate::reportGate() const
 		ss << "\"" << getSymbol() << "\"";
 	ss << ", line " << getLineNo() ;
   	getline(ss, report);
-	cout << setw(49) << left << report << "=" << endl;
-	cout << "==================================================" << endl;
+	os << setw(49) << left << report << "=" << endl;
+	os << "==================================================" << endl;
 }
 
 void
-CirGate::reportFanin(int level) const
+CirGate::reportFanin(int level, ostream& os) const
 {
-   assert (level >= 0);
-   setGlobalRef();
-   int cnt = 0;
-   preOrderReport(this, cnt, level, 'i', 0);
+   reportCone(level, true, os);
 }
 
 void
-CirGate::reportFanout(int level) const
+CirGate::reportFanout(int level, ostream& os) const
 {
-   assert (level >= 0);
-   setGlobalRef();
-   int cnt = 0;
-   preOrderReport(this, cnt, level, 'o', 0);
+   reportCone(level, false, os);
 }
 
 unsigned CirGate::_globalRef = 0;
 
+// Walk the cone in pre-order with an explicit stack, so that a deep cone
+// cannot overflow the call stack. Each stack entry is a gate being
+// expanded and the index of its next fanin (fanouts go from the last);
+// the depth of its fanins is thus the stack size. A gate is marked with
+// the global ref when expanded, and printed with (*) if met again above
+// 'level'. The lines end with '\n', as endl would flush each of them.
 void
-CirGate::preOrderReport(const CirGate* g, int &cnt, int &level, const char &usage, bool inv) const
+CirGate::reportCone(int level, bool fanin, ostream& os) const
 {
-	for(size_t i = 0; i < cnt; ++i)
-		cout << "  ";
-	if(inv)
-		cout << "!";
-	cout << g->getTypeStr() << " " << g->getId();
-	if(g->isGlobalRef() && cnt < level && g->getTypeStr() != "PI" && g->getTypeStr() != "PO" && g->getTypeStr() != "CONST")
-		cout << " (*)";
-	cout << endl;
-	if(g->isGlobalRef() && cnt < level)
-	{
-		--cnt;
-		return;
-	}
-	if(usage == 'i')
-	{
-		for(size_t i = 0; i < g->getFaninIdSize(); ++i)
-		{
-			if (g->getFaninPin(i).gate())
-			{
-				if(cnt < level)
-				{
-					preOrderReport(g->getFaninPin(i).gate(), ++cnt, level, usage, g->getFaninPin(i).isInv());
-					if(cnt < level - 1)
-						g->getFaninPin(i).gate()->setToGlobalRef();
-				}
-			}
-			else		// Floating gate
-			{
-				++cnt;
-				if(cnt <= level)
-				{
-					for(size_t j = 0; j < cnt; ++j)
-						cout << "  ";
-					if(g->getFaninPin(i).isInv())
-						cout << "!";
-					cout << "UNDEF" << " " << g->getFaninId(i) / 2 << endl;
-				}
-				--cnt;
-			}
-		}
-	}
-	else
-	{
-		for(int i = g->getFanoutPinSize() - 1; i >= 0 ; --i)
-		{
-			if (g->getFanoutPin(i).gate())
-			{
-				if(cnt < level)
-				{
-					preOrderReport(g->getFanoutPin(i).gate(), ++cnt, level, usage, g->getFanoutPin(i).isInv());
-					if(cnt < level - 1)
-						g->getFanoutPin(i).gate()->setToGlobalRef();
-				}
-			}
-		}
-	}
-	--cnt;
+   assert (level >= 0);
+   setGlobalRef();
+   vector<pair<const CirGate*, unsigned> > stack;
+   string indent;
+   os << getTypeStr() << " " << getId() << '\n';
+   if(level > 0)
+      stack.push_back(make_pair(this, 0));
+   while(!stack.empty())
+   {
+      const CirGate* g = stack.back().first;
+      unsigned i = stack.back().second++;
+      unsigned n = fanin? g->getFaninIdSize(): g->getFanoutPinSize();
+      if(i == n)
+      {
+         stack.pop_back();
+         continue;
+      }
+      size_t depth = stack.size();
+      pin p = fanin? g->getFaninPin(i): g->getFanoutPin(n - 1 - i);
+      if(indent.size() < 2 * depth)
+         indent.resize(2 * depth, ' ');
+      os.write(indent.data(), 2 * depth);
+      if(p.isInv())
+         os << "!";
+      if(!p.gate())		// Floating gate
+      {
+         os << "UNDEF " << g->getFaninId(i) / 2 << '\n';
+         continue;
+      }
+      os << p.gate()->getTypeStr() << " " << p.gate()->getId();
+      if(depth < (size_t)level)
+      {
+         if(!p.gate()->isGlobalRef())
+         {
+            p.gate()->setToGlobalRef();
+            stack.push_back(make_pair(p.gate(), 0));
+         }
+         else if(p.gate()->getType() == AIG_GATE)
+            os << " (*)";
+      }
+      os << '\n';
+   }
+   os.flush();
 }
\ No newline at end of file
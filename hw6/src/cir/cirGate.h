@@ -13,6 +13,7 @@
 #include <vector>
 #include <iostream>
 #include "cirDef.h"
+#include "myPool.h"
 
 using namespace std;
 
@@ -22,15 +23,67 @@ class pin
 {
 public:
 	#define NEG 0x1
+	pin(): _gateV(0) {}
 	pin(CirGate* g, size_t phase): 
 		_gateV(size_t(g) + phase) {}
 	CirGate* gate() const {
 		return (CirGate*)(_gateV & ~size_t(NEG)); }
 	bool isInv() const { return (_gateV & NEG); }
+	bool operator == (const pin& p) const { return _gateV == p._gateV; }
 private:
 	size_t           _gateV;
 };
 
+// Growable list of pins in the arena of the circuit (see CirMgr::_arena)
+// Growing abandons the old array to the arena, so reserve() the exact
+// size when it is known.
+class PinList
+{
+public:
+	PinList(): _data(0), _size(0), _cap(0) {}
+
+	unsigned size() const { return _size; }
+	const pin& operator [] (unsigned i) const { return _data[i]; }
+
+	void reserve(MyArena& a, unsigned n) {
+		if (n <= _cap) return;
+		pin* d = a.allocArr<pin>(n);
+		for(unsigned i = 0; i < _size; ++i)
+			d[i] = _data[i];
+		_data = d; _cap = n;
+	}
+	// Use the 'n' pins at 'd' (also in the arena)
+	void assign(pin* d, unsigned n) { _data = d; _size = _cap = n; }
+	void push_back(MyArena& a, const pin& p) {
+		if (_size == _cap) reserve(a, _cap? 2 * _cap: 2);
+		_data[_size++] = p;
+	}
+	// Remove the first pin equal to 'p', keeping the others in order
+	bool erase(const pin& p) {
+		unsigned i = 0;
+		while(i < _size && !(_data[i] == p))
+			++i;
+		if(i == _size)
+			return false;
+		for(--_size; i < _size; ++i)
+			_data[i] = _data[i + 1];
+		return true;
+	}
+	// Keep the pins 'p' with keep(p), in order
+	template <class F> void filter(F keep) {
+		unsigned n = 0;
+		for(unsigned i = 0; i < _size; ++i)
+			if(keep(_data[i]))
+				_data[n++] = _data[i];
+		_size = n;
+	}
+
+private:
+	pin*				_data;
+	unsigned			_size;
+	unsigned			_cap;
+};
+
 //------------------------------------------------------------------------
 //   Define classes
 //------------------------------------------------------------------------
@@ -39,52 +92,65 @@ class CirGate
 {
 public:
 	CirGate() {}
-	CirGate(unsigned ln = 0, unsigned id = 0):_LineNo(ln), _id(id), _symbol(""), _ref(0) {}
+	CirGate(unsigned ln = 0, unsigned id = 0):_numFanins(0), _LineNo(ln), _id(id), _ref(0), _symbol(0) {}
 	virtual ~CirGate() {}
 
 	// Basic access methods
 	virtual string getTypeStr() const { return ""; }
+	virtual GateType getType() const { return UNDEF_GATE; }
 	unsigned getLineNo() const { return _LineNo; }
 	unsigned getId() const { return _id; }
 
 	// Printing functions
 	virtual void printGate() const = 0;
-	void reportGate() const;
-	void reportFanin(int level) const;
-	void reportFanout(int level) const;
+	void reportGate(ostream&) const;
+	// Print the fanin or fanout cone of the gate in pre-order, down to
+	// 'level' levels; a gate already expanded is marked with (*)
+	void reportFanin(int level, ostream&) const;
+	void reportFanout(int level, ostream&) const;
 
-	void setSymbol(string &str) { _symbol = str; }
-	string getSymbol() const { return _symbol; }
+	// 'str' is kept, not copied; it lives in the arena of the circuit
+	void setSymbol(const char* str) { _symbol = str; }
+	string getSymbol() const { return _symbol? _symbol: ""; }
 
 	// Setting functions
-	void addFaninId(const unsigned &id) { _faninId.push_back(id); }
+	void addFaninId(const unsigned &id) { _faninId[_numFanins++] = id; }
+	void setFaninId(const size_t &idx, const unsigned &id) { _faninId[idx] = id; }
 	unsigned getFaninId(const size_t &idx) const { return _faninId[idx]; }
-	unsigned getFaninIdSize() const { return _faninId.size(); }
+	unsigned getFaninIdSize() const { return _numFanins; }
 	//void addFanoutId(const unsigned &id) { _fanoutId.push_back(id); }
 	//unsigned getFanoutId(const size_t &idx) { return _fanoutId[idx]; }
 
-	void addFaninPin(pin const &g) { _faninList.push_back(g); }
+	void setFaninPin(const size_t &idx, pin const &g) { _faninList[idx] = g; }
 	pin getFaninPin(const size_t &idx) const { return _faninList[idx]; }
-	void addFanoutPin(pin const &g) { _fanoutList.push_back(g); }
+	void reserveFanout(MyArena& a, unsigned n) { _fanoutList.reserve(a, n); }
+	void addFanoutPin(MyArena& a, pin const &g) { _fanoutList.push_back(a, g); }
+	void setFanoutPins(pin* d, unsigned n) { _fanoutList.assign(d, n); }
 	pin getFanoutPin(const size_t &idx) const { if(_fanoutList.size()) return _fanoutList[idx]; return pin(0,0); }
 	unsigned getFanoutPinSize() const { return _fanoutList.size(); }
+	template <class F> void filterFanoutPins(F keep) { _fanoutList.filter(keep); }
+	bool removeFanoutPin(pin const &g) { return _fanoutList.erase(g); }
 
 	// Dfs functions
 	bool isGlobalRef() const { return (_ref == _globalRef); }
 	void setToGlobalRef() { _ref = _globalRef; }
 	static void setGlobalRef() { ++_globalRef; }
-	void preOrderReport(const CirGate* g, int &cnt, int &level, const char &usage, bool inv) const;
 
 private:
-	vector<pin>   			_faninList;
-	IdList					_faninId;
-	vector<pin> 			_fanoutList;
-	//IdList					_fanoutId;
+	void reportCone(int level, bool fanin, ostream&) const;
+
+	// No member owns heap memory, so the gates of a circuit can be
+	// freed with its arena without calling their destructors
+	pin			   			_faninList[2];
+	unsigned					_faninId[2];
+	unsigned					_numFanins;
 	unsigned 				_LineNo;
+	PinList		 			_fanoutList;
+	//IdList					_fanoutId;
 	unsigned					_id;
-	string 					_symbol;
-	static unsigned		_globalRef;
 	unsigned					_ref;
+	const char* 			_symbol;
+	static unsigned		_globalRef;
 
 protected:
 	
@@ -98,6 +164,7 @@ public:
 
 	// Basic access methods
 	string getTypeStr() const { return "AIG";}
+	GateType getType() const { return AIG_GATE; }
 
 	// Printing functions
 	void printGate() const {}
@@ -111,6 +178,7 @@ public:
 
 	// Basic access methods
 	string getTypeStr() const { return "PI";}
+	GateType getType() const { return PI_GATE; }
 
 	// Printing functions
 	void printGate() const {}
@@ -125,6 +193,7 @@ public:
 
 	// Basic access methods
 	string getTypeStr() const { return "PO";}
+	GateType getType() const { return PO_GATE; }
 
 	// Printing functions
 	void printGate() const {}
@@ -139,6 +208,7 @@ public:
 
 	// Basic access methods
 	string getTypeStr() const { return "CONST";}
+	GateType getType() const { return CONST_GATE; }
 
 	// Printing functions
 	void printGate() const {}
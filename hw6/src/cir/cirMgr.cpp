@@ -13,9 +13,14 @@
 #include <cassert>
 #include <cstring>
 #include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "cirMgr.h"
 #include "cirGate.h"
 #include "util.h"
+#include "myThread.h"
 
 using namespace std;
 
@@ -26,6 +31,8 @@ using namespace std;
 /*******************************/
 CirMgr* cirMgr = 0;
 
+const unsigned CirMgr::NO_DFS_POS;
+
 enum CirParseError {
 	EXTRA_SPACE,
 	MISSING_SPACE,
@@ -152,6 +159,15 @@ parseError(CirParseError err)
 bool
 CirMgr::readCircuit(const string& fileName)
 {
+	// A binary AIGER file is only read through the mapped file, which
+	// reports its errors
+	bool binary = false;
+	if(readCircuitMapped(fileName, binary))
+		return true;
+	if(binary)
+		return false;
+	resetCircuit();
+
 	ifstream ifs(fileName.c_str());
 	if(!ifs)
 	{
@@ -410,7 +426,8 @@ CirMgr::readCircuit(const string& fileName)
 	_maxId = m + o + 1;
 
 	//cout<<"read MILOA:"<<m<<","<<i<<","<<l<<","<<o<<","<<a<<endl;
-	_gates = new CirGate* [m + o + 1] {0};
+	_gates = _arena.allocArr<CirGate*>(m + o + 1);
+	fill(_gates, _gates + m + o + 1, (CirGate*)0);
 
 	//const 0
 	_gates[0] = _const;
@@ -498,7 +515,7 @@ CirMgr::readCircuit(const string& fileName)
 		if(end != string::npos)
 			return parseError(MISSING_NEWLINE);
 		
-		CirGate* newPI = new PI(lineNo + 1, id);
+		CirGate* newPI = _gatePool.create<PI>(lineNo + 1, id);
 		_PIs.push_back(newPI);
 		_gates[id] = newPI;
 		//cout << "id:"<<id<<", gate:PI, line:"<<lineNo<<endl;
@@ -562,7 +579,7 @@ CirMgr::readCircuit(const string& fileName)
 		if(end != string::npos)
 			return parseError(MISSING_NEWLINE);
 
-		CirGate* newPO = new PO(lineNo + 1, m + j + 1);
+		CirGate* newPO = _gatePool.create<PO>(lineNo + 1, m + j + 1);
 		_POs.push_back(newPO);
 		_gates[m + j + 1] = newPO;
 		newPO->addFaninId(fanInId);
@@ -736,7 +753,7 @@ CirMgr::readCircuit(const string& fileName)
 		if(end != string::npos)
 			return parseError(MISSING_NEWLINE);
 
-		CirGate* newAIG = new AIG(lineNo + 1, id);
+		CirGate* newAIG = _gatePool.create<AIG>(lineNo + 1, id);
 		_AIGs.push_back(newAIG);
 		_gates[id] = newAIG;
 		newAIG->addFaninId(fanInId1);
@@ -879,14 +896,17 @@ CirMgr::readCircuit(const string& fileName)
 			++colNo;
 		}
 
+		// The name lives as long as the circuit
+		char* name = _arena.allocArr<char>(token.size() + 1);
+		memcpy(name, token.c_str(), token.size() + 1);
 		if(symbol[0] == 'i')
 		{
-			_PIs[id]->setSymbol(token);
+			_PIs[id]->setSymbol(name);
 			//cout<<"PI"<<id<<" symbol:"<<tokent<<endl;
 		}
 		else if(symbol[0] == 'o')
 		{
-			_POs[id]->setSymbol(token);
+			_POs[id]->setSymbol(name);
 			//cout<<"PO"<<id<<" symbol"<<token<<endl;
 		}
 	}while(symbol[0] != 'c');
@@ -901,149 +921,604 @@ CirMgr::readCircuit(const string& fileName)
 			return parseError(MISSING_NEWLINE);
 	}
 
+	connectCircuit();
+
+	return true;
+}
+
+// Connect the fanins and fanouts by the literal IDs read in, and
+// collect the floating and unused gates
+void
+CirMgr::connectCircuit()
+{
 	// Gen connection
-	// PO
-	for(size_t j = 0; j < _POs.size(); ++j)
+	// The fanout lists of all the gates are laid out in one array: count
+	// the fanouts, fill them in at the cursors 'pos', and then hand each
+	// gate its slice. With several threads, thread k first sorts chunk k
+	// of the fanins by bins of fanin IDs ('idx', by bin, then chunk). The
+	// bins are grouped into t ranges of about the same work, and thread k
+	// counts and fills the fanouts of range k from its part of 'idx',
+	// which lists them in order; so the fanout lists are the same as with
+	// one thread.
+	size_t o = _POs.size(), a = _AIGs.size(), n = o + 2 * a;
+	unsigned t = (n > 4096)? _numThreads: 1;
+	// lits[j]: fanin of PO j; lits[o + 2j + k]: fanin k of AIG j
+	IdList lits(n);
+	for(size_t j = 0; j < o; ++j)
+		lits[j] = _POs[j]->getFaninId(0);
+	parallelRanges(a, t, [&](unsigned, size_t b, size_t e) {
+		for(size_t j = b; j < e; ++j)
+		{
+			lits[o + 2 * j] = _AIGs[j]->getFaninId(0);
+			lits[o + 2 * j + 1] = _AIGs[j]->getFaninId(1);
+		}
+	});
+	// Bin i has the IDs j with j * numBins / _maxId == i, from
+	// firstId(i); off[k][i]: where the fanins of chunk k in bin i go in
+	// 'idx'. Range k has the bins from binBound[k] and the IDs from
+	// idBound[k]. One thread goes through the fanins as they are.
+	size_t numBins = (t > 1)? 64 * t: 1;
+	auto firstId = [&](size_t i) {
+		return (i * _maxId + numBins - 1) / numBins; };
+	IdList idx(t > 1? n: 0), binBound(t + 1, 0), idBound(t + 1, 0);
+	vector<IdList> off(t, IdList(numBins + 1, 0));
+	binBound[t] = numBins;
+	idBound[t] = _maxId;
+	off[0][numBins] = n;
+	if(t > 1)
 	{
-		unsigned fanInId = _POs[j]->getFaninId(0);
-		if(fanInId % 2 == 0)
+		auto binOf = [&](unsigned lit) {
+			return size_t(lit / 2) * numBins / _maxId; };
+		parallelRanges(n, t, [&](unsigned k, size_t b, size_t e) {
+			for(size_t j = b; j < e; ++j)
+				++off[k][binOf(lits[j])];
+		});
+		// The work of a bin is its #fanins plus its #IDs
+		size_t sum = 0, work = 0, total = n + _maxId;
+		unsigned r = 1;
+		for(size_t i = 0; i < numBins; ++i)
 		{
-			fanInId /= 2;
-			_POs[j]->addFaninPin(pin(_gates[fanInId], 0));
-			if(_gates[fanInId])
-				_gates[fanInId]->addFanoutPin(pin(_POs[j], 0));
-			else
-				_float.push_back(_POs[j]->getId());
+			for(unsigned k = 0; k < t; ++k)
+			{
+				size_t c = off[k][i];
+				off[k][i] = sum;
+				sum += c;
+				work += c;
+			}
+			work += firstId(i + 1) - firstId(i);
+			while(r < t && work * t >= total * r)
+				binBound[r++] = i + 1;
 		}
-		else
+		for(unsigned r = 1; r < t; ++r)
+			idBound[r] = firstId(binBound[r]);
+		parallelRanges(n, t, [&](unsigned k, size_t b, size_t e) {
+			IdList cur(off[k]);
+			for(size_t j = b; j < e; ++j)
+				idx[cur[binOf(lits[j])]++] = j;
+		});
+	}
+	auto fanin = [&](size_t i) { return (t > 1)? idx[i]: i; };
+	// The fanins of range k are from off[0][binBound[k]] in 'idx', and
+	// so are its fanouts in 'fanouts'
+	IdList pos(_maxId, 0);
+	pin* fanouts = _arena.allocArr<pin>(n);
+	parallelRanges(t, t, [&](unsigned k, size_t, size_t) {
+		size_t begin = off[0][binBound[k]], end = off[0][binBound[k + 1]];
+		for(size_t i = begin; i < end; ++i)
+			++pos[lits[fanin(i)] / 2];
+		for(size_t j = idBound[k], p = begin; j < idBound[k + 1]; ++j)
 		{
-			fanInId /= 2;
-			_POs[j]->addFaninPin(pin(_gates[fanInId], 1));
-			if(_gates[fanInId])
-				_gates[fanInId]->addFanoutPin(pin(_POs[j], 1));
-			else
-				_float.push_back(_POs[j]->getId());
+			size_t c = pos[j];
+			pos[j] = p;
+			p += c;
 		}
-		/*
-		cout<<"PO"<<j<<"'s fanInId:";
-		if(_POs[j]->getFaninPin(0).isInv())
-			cout<<"!";
-		cout<<fanInId<<endl;
-		*/
+		for(size_t i = begin; i < end; ++i)
+		{
+			size_t j = fanin(i);
+			CirGate* g = (j < o)? _POs[j]: _AIGs[(j - o) / 2];
+			fanouts[pos[lits[j] / 2]++] = pin(g, lits[j] % 2);
+		}
+	});
+	// Fanins; PO
+	for(size_t j = 0; j < o; ++j)
+	{
+		CirGate* fanIn = _gates[lits[j] / 2];
+		_POs[j]->setFaninPin(0, pin(fanIn, lits[j] % 2));
+		if(!fanIn)
+			_float.push_back(_POs[j]->getId());
 	}
 	//AIG
-	for(size_t j = 0; j < _AIGs.size(); ++j)
-	{
-		unsigned fanInId1 = _AIGs[j]->getFaninId(0);
-		unsigned fanInId2 = _AIGs[j]->getFaninId(1);
-		if(fanInId1 % 2 == 0 && fanInId2 % 2 == 0)
-		{
-			
-			fanInId1 /= 2;
-			fanInId2 /= 2;
-			_AIGs[j]->addFaninPin(pin(_gates[fanInId1], 0));
-			_AIGs[j]->addFaninPin(pin(_gates[fanInId2], 0));
-			if(_gates[fanInId1] && _gates[fanInId2])
-			{
-				_gates[fanInId1]->addFanoutPin(pin(_AIGs[j], 0));
-				_gates[fanInId2]->addFanoutPin(pin(_AIGs[j], 0));
-			}
-			else
+	vector<IdList> floats(t);
+	parallelRanges(a, t, [&](unsigned k, size_t b, size_t e) {
+		for(size_t j = b; j < e; ++j)
+		{
+			bool floating = false;
+			for(size_t i = 0; i < 2; ++i)
 			{
-				_float.push_back(_AIGs[j]->getId());
-				if(_gates[fanInId1])
-					_gates[fanInId1]->addFanoutPin(pin(_AIGs[j], 0));
-				if(_gates[fanInId2])
-					_gates[fanInId2]->addFanoutPin(pin(_AIGs[j], 0));
+				unsigned fanInId = lits[o + 2 * j + i];
+				CirGate* fanIn = _gates[fanInId / 2];
+				_AIGs[j]->setFaninPin(i, pin(fanIn, fanInId % 2));
+				if(!fanIn)
+					floating = true;
 			}
+			if(floating)
+				floats[k].push_back(_AIGs[j]->getId());
 		}
-		else if(fanInId1 % 2 ==0 && fanInId2 % 2 == 1)
+	});
+	// Now pos[j] is where the fanouts of j + 1 begin; the PIs and AIGs
+	// (IDs 1..m) without fanouts are unused
+	size_t m = _maxId - o - 1;
+	vector<IdList> unused(t);
+	parallelRanges(_maxId, t, [&](unsigned k, size_t b, size_t e) {
+		for(size_t j = b; j < e; ++j)
 		{
-			fanInId1 /= 2;
-			fanInId2 /= 2;
-			_AIGs[j]->addFaninPin(pin(_gates[fanInId1], 0));
-			_AIGs[j]->addFaninPin(pin(_gates[fanInId2], 1));
-			if(_gates[fanInId1] && _gates[fanInId2])
-			{
-				_gates[fanInId1]->addFanoutPin(pin(_AIGs[j], 0));
-				_gates[fanInId2]->addFanoutPin(pin(_AIGs[j], 1));
-			}
-			else
-			{
-				_float.push_back(_AIGs[j]->getId());
-				if(_gates[fanInId1])
-					_gates[fanInId1]->addFanoutPin(pin(_AIGs[j], 0));
-				if(_gates[fanInId2])
-					_gates[fanInId2]->addFanoutPin(pin(_AIGs[j], 1));
-			}
+			size_t begin = j? pos[j - 1]: 0;
+			if(!_gates[j])
+				continue;
+			if(pos[j] > begin)
+				_gates[j]->setFanoutPins(fanouts + begin, pos[j] - begin);
+			else if(j > 0 && j <= m)
+				unused[k].push_back(j);
 		}
-		else if(fanInId1 % 2 ==1 && fanInId2 % 2 == 0)
+	});
+	for(unsigned k = 0; k < t; ++k)
+	{
+		_float.insert(_float.end(), floats[k].begin(), floats[k].end());
+		_unused.insert(_unused.end(), unused[k].begin(), unused[k].end());
+	}
+	sort(_float.begin(), _float.end());
+}
+
+// Drop the partially read circuit
+void
+CirMgr::resetCircuit()
+{
+	_PIs.clear();
+	_POs.clear();
+	_AIGs.clear();
+	_float.clear();
+	_unused.clear();
+	_listsDirty = false;
+	_deleted.clear();
+	_batchEdits = false;
+	_dfsUnreached.clear();
+	_gates = 0;
+	_gatesCap = 0;
+	invalidateDfsList();
+	invalidateLevels();
+	_gatePool.clear();
+	_arena.reset();
+	_const = _gatePool.create<Const0>();
+}
+
+void
+CirMgr::compact()
+{
+	if(_compact)
+		return;
+	flushDeleted();
+	tidyGateLists();
+	_compact = new CirCompact(_gates, _maxId, _PIs, _POs, _float, _unused);
+	GateList().swap(_PIs);
+	GateList().swap(_POs);
+	GateList().swap(_AIGs);
+	IdList().swap(_float);
+	IdList().swap(_unused);
+	GateList().swap(_dfsList);
+	_dfsDone = false;
+	IdList().swap(_dfsPos);
+	_dfsHoles = 0;
+	IdList().swap(_simIds);
+	IdList().swap(_simLevel);
+	vector<IdList>().swap(_fecGrps);
+	IdList().swap(_simFanin);
+	IdList().swap(_simPo);
+	vector<uint64_t>().swap(_simValue);
+	IdList().swap(_level);
+	vector<IdList>().swap(_levelList);
+	IdList().swap(_levelPos);
+	_gates = 0;
+	_gatesCap = 0;
+	_const = 0;
+	_gatePool.clear();
+	_arena.release();
+}
+
+// Read a decimal of at most 9 digits (so that it fits in an int)
+static inline bool
+lexNum(const char*& p, const char* e, unsigned& n)
+{
+	const char* s = p;
+	n = 0;
+	while(p < e && p - s < 10 && unsigned(*p - '0') < 10)
+		n = n * 10 + unsigned(*p++ - '0');
+	return p != s && p - s < 10;
+}
+
+static inline bool
+lexChar(const char*& p, const char* e, char c)
+{
+	if(p == e || *p != c)
+		return false;
+	++p;
+	return true;
+}
+
+// Fast path of readCircuit(): the file is mapped and scanned in place.
+// Only well-formed .aag files are accepted; for anything else it returns
+// false without a message, and the file is parsed again by the checking
+// parser for the diagnostics. A file with the "aig" header is read as
+// binary AIGER and 'binary' is set.
+bool
+CirMgr::readCircuitMapped(const string& fileName, bool& binary)
+{
+	int fd = open(fileName.c_str(), O_RDONLY);
+	if(fd < 0)
+		return false;
+	struct stat st;
+	if(fstat(fd, &st) != 0 || st.st_size == 0)
+	{
+		close(fd);
+		return false;
+	}
+	int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+	flags |= MAP_POPULATE;
+#endif
+	void* data = mmap(0, st.st_size, PROT_READ, flags, fd, 0);
+	close(fd);
+	if(data == MAP_FAILED)
+		return false;
+	madvise(data, st.st_size, MADV_SEQUENTIAL);
+	const char* p = (const char*)data;
+	bool ok;
+	if(st.st_size > 4 && memcmp(p, "aig ", 4) == 0)
+	{
+		binary = true;
+		ok = parseAig(p, p + st.st_size);
+	}
+	else
+		ok = parseMapped(p, p + st.st_size);
+	munmap(data, st.st_size);
+	return ok;
+}
+
+bool
+CirMgr::parseMapped(const char* p, const char* e)
+{
+	unsigned m, i, l, o, a;
+	if(!(lexChar(p, e, 'a') && lexChar(p, e, 'a') && lexChar(p, e, 'g') &&
+		lexChar(p, e, ' ') && lexNum(p, e, m) && lexChar(p, e, ' ') &&
+		lexNum(p, e, i) && lexChar(p, e, ' ') && lexNum(p, e, l) &&
+		lexChar(p, e, ' ') && lexNum(p, e, o) && lexChar(p, e, ' ') &&
+		lexNum(p, e, a) && lexChar(p, e, '\n')))
+		return false;
+	if(m < i + a || l != 0)
+		return false;
+
+	_maxId = m + o + 1;
+	_gates = _arena.allocArr<CirGate*>(m + o + 1);
+	fill(_gates, _gates + m + o + 1, (CirGate*)0);
+	_gates[0] = _const;
+	_PIs.reserve(i);
+	_POs.reserve(o);
+	_AIGs.reserve(a);
+
+	unsigned line = 1, id, fanInId1;
+	//PI
+	for(unsigned j = 0; j < i; ++j)
+	{
+		if(!lexNum(p, e, id) || !lexChar(p, e, '\n'))
+			return false;
+		if(id < 2 || id % 2 != 0 || id / 2 > m || _gates[id / 2])
+			return false;
+		CirGate* newPI = _gatePool.create<PI>(++line, id / 2);
+		_PIs.push_back(newPI);
+		_gates[id / 2] = newPI;
+	}
+	//PO
+	for(unsigned j = 0; j < o; ++j)
+	{
+		if(!lexNum(p, e, fanInId1) || !lexChar(p, e, '\n'))
+			return false;
+		if(fanInId1 / 2 > m)
+			return false;
+		CirGate* newPO = _gatePool.create<PO>(++line, m + j + 1);
+		_POs.push_back(newPO);
+		_gates[m + j + 1] = newPO;
+		newPO->addFaninId(fanInId1);
+	}
+	//AIG
+	// The rest of the file is split at line starts into a chunk for each
+	// thread. The lines of each chunk are counted first, so that its AIG
+	// lines can be parsed into the AIGs of their indices.
+	unsigned t = (a > 4096)? _numThreads: 1;
+	vector<const char*> chunk(t + 1, e);
+	chunk[0] = p;
+	for(unsigned k = 1; k < t; ++k)
+	{
+		const char* q = max(p + (e - p) * k / t, chunk[k - 1]);
+		q = (const char*)memchr(q, '\n', e - q);
+		chunk[k] = q? q + 1: e;
+	}
+	vector<size_t> firstLine(t + 1, 0);
+	parallelRanges(t, t, [&](unsigned k, size_t, size_t) {
+		size_t n = 0;
+		for(const char* q = chunk[k]; (q = (const char*)memchr(q, '\n', chunk[k + 1] - q)); ++q)
+			++n;
+		firstLine[k + 1] = n;
+	});
+	for(unsigned k = 0; k < t; ++k)
+		firstLine[k + 1] += firstLine[k];
+	if(firstLine[t] < a)
+		return false;
+
+	AIG* aigs = _gatePool.allocArr<AIG>(a);
+	_AIGs.resize(a);
+	vector<char> ok(t, 1);
+	const char* aigEnd = p;
+	parallelRanges(t, t, [&](unsigned k, size_t, size_t) {
+		const char* q = chunk[k];
+		unsigned id, fanInId1, fanInId2;
+		for(size_t j = firstLine[k]; j < a && q < chunk[k + 1]; ++j)
 		{
-			fanInId1 /= 2;
-			fanInId2 /= 2;
-			_AIGs[j]->addFaninPin(pin(_gates[fanInId1], 1));
-			_AIGs[j]->addFaninPin(pin(_gates[fanInId2], 0));
-			if(_gates[fanInId1] && _gates[fanInId2])
+			if(!lexNum(q, e, id) || !lexChar(q, e, ' ') ||
+				!lexNum(q, e, fanInId1) || !lexChar(q, e, ' ') ||
+				!lexNum(q, e, fanInId2) || !lexChar(q, e, '\n') ||
+				id < 2 || id % 2 != 0 || id / 2 > m ||
+				fanInId1 / 2 > m || fanInId2 / 2 > m)
 			{
-				_gates[fanInId1]->addFanoutPin(pin(_AIGs[j], 1));
-				_gates[fanInId2]->addFanoutPin(pin(_AIGs[j], 0));
+				ok[k] = 0;
+				return;
 			}
-			else
+			AIG* newAIG = new (aigs + j) AIG(line + j + 1, id / 2);
+			// Another thread may define the same ID
+			if(!__sync_bool_compare_and_swap(_gates + id / 2, (CirGate*)0, (CirGate*)newAIG))
 			{
-				_float.push_back(_AIGs[j]->getId());
-				if(_gates[fanInId1])
-					_gates[fanInId1]->addFanoutPin(pin(_AIGs[j], 1));
-				if(_gates[fanInId2])
-					_gates[fanInId2]->addFanoutPin(pin(_AIGs[j], 0));
+				ok[k] = 0;
+				return;
 			}
+			_AIGs[j] = newAIG;
+			newAIG->addFaninId(fanInId1);
+			newAIG->addFaninId(fanInId2);
+			if(j + 1 == a)
+				aigEnd = q;
+		}
+	});
+	if(find(ok.begin(), ok.end(), 0) != ok.end())
+		return false;
+	p = aigEnd;
+	if(!parseMappedSymbols(p, e, false))
+		return false;
+
+	connectCircuit();
+	return true;
+}
+
+// Symbols and comment of a mapped file, up to the end of the file.
+// The errors are reported only if 'report' (an .aag file is parsed again
+// by the checking parser instead).
+bool
+CirMgr::parseMappedSymbols(const char*& p, const char* e, bool report)
+{
+	unsigned id;
+	for(; p < e && *p != 'c'; ++p)
+	{
+		++lineNo;
+		colNo = 0;
+		const char* line = p;
+		char type = *p++;
+		if(type != 'i' && type != 'o')
+		{
+			errMsg = type;
+			return report? parseError(ILLEGAL_SYMBOL_TYPE): false;
 		}
-		else if(fanInId1 % 2 ==1 && fanInId2 % 2 == 1)
+		colNo = 1;
+		if(!lexNum(p, e, id))
 		{
-			fanInId1 /= 2;
-			fanInId2 /= 2;
-			_AIGs[j]->addFaninPin(pin(_gates[fanInId1], 1));
-			_AIGs[j]->addFaninPin(pin(_gates[fanInId2], 1));
-			if(_gates[fanInId1] && _gates[fanInId2])
-			{
-				_gates[fanInId1]->addFanoutPin(pin(_AIGs[j], 1));
-				_gates[fanInId2]->addFanoutPin(pin(_AIGs[j], 1));
-			}
-			else
+			errMsg = "symbol index";
+			return report? parseError(MISSING_NUM): false;
+		}
+		GateList& gates = (type == 'i')? _PIs: _POs;
+		if(id >= gates.size())
+		{
+			errInt = id;
+			errMsg = (type == 'i')? "PI index": "PO index";
+			return report? parseError(NUM_TOO_BIG): false;
+		}
+		if(gates[id]->getSymbol() != "")
+		{
+			errMsg = type;
+			errInt = id;
+			return report? parseError(REDEF_SYMBOLIC_NAME): false;
+		}
+		colNo = p - line;
+		if(!lexChar(p, e, ' '))
+			return report? parseError(MISSING_SPACE): false;
+		const char* begin = p;
+		bool blank = true;
+		for(; p < e && *p != '\n'; ++p)
+		{
+			if(*p < 0x20 || *p > 0x7e)
 			{
-				_float.push_back(_AIGs[j]->getId());
-				if(_gates[fanInId1])
-					_gates[fanInId1]->addFanoutPin(pin(_AIGs[j], 1));
-				if(_gates[fanInId2])
-					_gates[fanInId2]->addFanoutPin(pin(_AIGs[j], 1));
+				colNo = p - line;
+				errInt = int(*p);
+				return report? parseError(ILLEGAL_SYMBOL_NAME): false;
 			}
+			if(*p != ' ')
+				blank = false;
+		}
+		if(blank)
+		{
+			errMsg = "symbolic name";
+			return report? parseError(MISSING_IDENTIFIER): false;
+		}
+		if(p == e)
+		{
+			colNo = p - line;
+			return report? parseError(MISSING_NEWLINE): false;
 		}
-		/*
-		cout<<"AIG"<<_AIGs[j]->getId()<<"'s fanInId1:";
-		if(_AIGs[j]->getFaninPin(0).isInv())
-			cout<<"!";
-		cout<<fanInId1<<endl;
-		cout<<"AIG"<<_AIGs[j]->getId()<<"'s fanInId2:";
-		if(_AIGs[j]->getFaninPin(1).isInv())
-			cout<<"!";
-		cout<<fanInId2<<endl;
-		*/
+		char* name = _arena.allocArr<char>(p - begin + 1);
+		memcpy(name, begin, p - begin);
+		name[p - begin] = 0;
+		gates[id]->setSymbol(name);
 	}
-	sort(_float.begin(), _float.end());
-	// Check unused
-	// AIG
-	for(size_t j = 0; j < _AIGs.size(); ++j)
+	// Comment
+	if(p < e && p + 1 < e && p[1] != '\n')
+	{
+		++lineNo;
+		colNo = 1;
+		return report? parseError(MISSING_NEWLINE): false;
+	}
+	return true;
+}
+
+// Delta of a binary AIGER AND gate: 7 bits per byte, least significant
+// first, with the high bit set on all but the last byte
+static inline bool
+lexDelta(const char*& p, const char* e, unsigned& n)
+{
+	n = 0;
+	for(unsigned shift = 0; p < e && shift < 32; shift += 7)
+	{
+		unsigned char c = *p++;
+		n |= unsigned(c & 0x7f) << shift;
+		if(!(c & 0x80))
+			return true;
+	}
+	return false;
+}
+
+static inline void
+writeDelta(ostream& os, unsigned n)
+{
+	for(; n & ~0x7fu; n >>= 7)
+		os.put(char((n & 0x7f) | 0x80));
+	os.put(char(n));
+}
+
+// Binary AIGER: "aig M I L O A" with M = I + L + A; the PIs are 1..I and
+// the AIGs I+1..M, each given by the deltas lhs - rhs0 and rhs0 - rhs1
+// (lhs > rhs0 >= rhs1). The gates get the line numbers they would have
+// in the .aag file; the AND section counts as one line.
+bool
+CirMgr::parseAig(const char* p, const char* e)
+{
+	static const char* const fields[5] = { "number of variables",
+		"number of PIs", "number of latches", "number of POs", "number of AIGs" };
+	unsigned n[5];
+	lineNo = 0;
+	colNo = 3;
+	p += 3;
+	for(size_t k = 0; k < 5; ++k)
+	{
+		if(!lexChar(p, e, ' '))
+			return parseError(MISSING_SPACE);
+		++colNo;
+		const char* begin = p;
+		if(!lexNum(p, e, n[k]))
+		{
+			errMsg = fields[k];
+			return parseError(MISSING_NUM);
+		}
+		colNo += p - begin;
+	}
+	if(!lexChar(p, e, '\n'))
+		return parseError(MISSING_NEWLINE);
+	unsigned m = n[0], i = n[1], l = n[2], o = n[3], a = n[4];
+	if(l != 0)
 	{
-		if(_AIGs[j]->getFanoutPin(0).gate() == 0)
-			_unused.push_back(_AIGs[j]->getId());
+		errMsg = "latches";
+		return parseError(ILLEGAL_NUM);
 	}
-	// PI
-	for(size_t j = 0; j < _PIs.size(); ++j)
+	if(m != i + a)
 	{
-		if(_PIs[j]->getFanoutPin(0).gate() == 0)
-			_unused.push_back(_PIs[j]->getId());
+		errMsg = "Number of variables";
+		errInt = m;
+		return parseError((m < i + a)? NUM_TOO_SMALL: NUM_TOO_BIG);
 	}
-	sort(_unused.begin(), _unused.end());
 
+	_maxId = m + o + 1;
+	_gates = _arena.allocArr<CirGate*>(m + o + 1);
+	_gates[0] = _const;
+	_PIs.reserve(i);
+	_POs.reserve(o);
+	_AIGs.reserve(a);
+	//PI
+	for(unsigned j = 0; j < i; ++j)
+	{
+		CirGate* newPI = _gatePool.create<PI>(j + 2, j + 1);
+		_PIs.push_back(newPI);
+		_gates[j + 1] = newPI;
+	}
+	//PO
+	unsigned fanInId0, fanInId1, delta;
+	for(unsigned j = 0; j < o; ++j)
+	{
+		++lineNo;
+		colNo = 0;
+		if(p == e)
+		{
+			errMsg = "PO";
+			return parseError(MISSING_DEF);
+		}
+		const char* begin = p;
+		if(!lexNum(p, e, fanInId0))
+		{
+			errMsg = "PO literal ID";
+			return parseError(MISSING_NUM);
+		}
+		if(fanInId0 / 2 > m)
+		{
+			errInt = fanInId0;
+			return parseError(MAX_LIT_ID);
+		}
+		colNo = p - begin;
+		if(!lexChar(p, e, '\n'))
+			return parseError(MISSING_NEWLINE);
+		CirGate* newPO = _gatePool.create<PO>(i + j + 2, m + j + 1);
+		_POs.push_back(newPO);
+		_gates[m + j + 1] = newPO;
+		newPO->addFaninId(fanInId0);
+	}
+	//AIG
+	++lineNo;
+	colNo = 0;
+	for(unsigned j = 0; j < a; ++j)
+	{
+		unsigned id = i + j + 1;
+		if(!lexDelta(p, e, delta))
+		{
+			errMsg = "AIG";
+			return parseError(MISSING_DEF);
+		}
+		if(delta == 0 || delta > 2 * id)
+		{
+			errMsg = "AIG input literal delta";
+			return parseError(ILLEGAL_NUM);
+		}
+		fanInId0 = 2 * id - delta;
+		if(!lexDelta(p, e, delta))
+		{
+			errMsg = "AIG";
+			return parseError(MISSING_DEF);
+		}
+		if(delta > fanInId0)
+		{
+			errMsg = "AIG input literal delta";
+			return parseError(ILLEGAL_NUM);
+		}
+		fanInId1 = fanInId0 - delta;
+		CirGate* newAIG = _gatePool.create<AIG>(i + o + j + 2, id);
+		_AIGs.push_back(newAIG);
+		_gates[id] = newAIG;
+		newAIG->addFaninId(fanInId0);
+		newAIG->addFaninId(fanInId1);
+	}
+	if(!parseMappedSymbols(p, e, true))
+		return false;
+
+	connectCircuit();
 	return true;
 }
 
@@ -1062,31 +1537,51 @@ Circuit Statistics
 void
 CirMgr::printSummary() const
 {
+	if(_compact)
+		return _compact->printSummary();
 	cout << endl;
 	cout << "Circuit Statistics" << endl;
 	cout << "==================" << endl;
 	cout << "  PI   " << setw(9) << right << _PIs.size() << endl;
 	cout << "  PO   " << setw(9) << right << _POs.size() << endl;
-	cout << "  AIG  " << setw(9) << right << _AIGs.size() << endl;
+	// The AIGs deleted by the edits may still be in _AIGs
+	size_t numAIGs = _AIGs.size() - _deleted.size();
+	cout << "  AIG  " << setw(9) << right << numAIGs << endl;
 	cout << "------------------" << endl;
-	cout << "  Total" << setw(9) << _PIs.size() + _POs.size() + _AIGs.size() << right << endl;
+	cout << "  Total" << setw(9) << _PIs.size() + _POs.size() + numAIGs << right << endl;
 }
 
 void
 CirMgr::printNetlist() const
 {
+	if(_compact)
+		return _compact->printNetlist();
 	cout << endl;
-	unsigned cnt = 0;
-	CirGate::setGlobalRef();
-	for(size_t i = 0; i < _POs.size(); ++i)
+	const GateList& dfsList = getDfsList();
+	for(size_t n = 0; n < dfsList.size(); ++n)
 	{
-		dfs(_POs[i], cnt, 'n', cout);
+		const CirGate* g = dfsList[n];
+		cout << "[" << n << "] " << setw(4) << left << g->getTypeStr() << g->getId();
+		for(size_t i = 0; i < g->getFaninIdSize(); ++i)
+		{
+			cout << " ";
+			if(!g->getFaninPin(i).gate())
+				cout << "*";
+			if(g->getFaninId(i) % 2 != 0)
+				cout << "!";
+			cout << g->getFaninId(i) / 2 ;
+		}
+		if(g->getSymbol() != "")
+			cout << " (" << g->getSymbol() << ")";
+		cout << endl;
 	}
 }
 
 void
 CirMgr::printPIs() const
 {
+	if(_compact)
+		return _compact->printPIs();
 	cout << "PIs of the circuit:";
 	for(size_t i = 0; i < _PIs.size(); ++i)
 		cout<<" "<< _PIs[i]->getId();
@@ -1096,6 +1591,8 @@ CirMgr::printPIs() const
 void
 CirMgr::printPOs() const
 {
+	if(_compact)
+		return _compact->printPOs();
 	cout << "POs of the circuit:";
 	for(size_t i = 0; i < _POs.size(); ++i)
 		cout<<" "<< _POs[i]->getId();
@@ -1105,6 +1602,9 @@ CirMgr::printPOs() const
 void
 CirMgr::printFloatGates() const
 {
+	if(_compact)
+		return _compact->printFloatGates();
+	tidyGateLists();
 	if(_float.size())
 	{
 		cout << "Gates with floating fanin(s):";
@@ -1121,24 +1621,116 @@ CirMgr::printFloatGates() const
 	}
 }
 
+// Each FEC group on a line, as gate IDs in increasing order; a '!'
+// marks a gate inverse to the first one. The groups are ordered by their
+// first gates.
 void
-CirMgr::writeAag(ostream& outfile) const
+CirMgr::printFECPairs() const
 {
-	unsigned cnt = 0;
-	CirGate::setGlobalRef();
-	for(size_t i = 0; i < _POs.size(); ++i)
+	vector<IdList> grps(_fecGrps.size());
+	for(size_t g = 0; g < _fecGrps.size(); ++g)
+	{
+		IdList& grp = grps[g];
+		for(size_t i = 0; i < _fecGrps[g].size(); ++i)
+		{
+			unsigned lit = _fecGrps[g][i];
+			grp.push_back(_simIds[lit / 2] * 2 + lit % 2);
+		}
+		sort(grp.begin(), grp.end());
+		unsigned inv = grp[0] % 2;
+		for(size_t i = 0; i < grp.size(); ++i)
+			grp[i] ^= inv;
+	}
+	sort(grps.begin(), grps.end());
+	for(size_t g = 0; g < grps.size(); ++g)
+	{
+		cout << "[" << g << "]";
+		for(size_t i = 0; i < grps[g].size(); ++i)
+			cout << " " << (grps[g][i] % 2? "!": "") << grps[g][i] / 2;
+		cout << endl;
+	}
+}
+
+// #Bytes of the circuit storage, and per gate (PI, PO and AIG)
+void
+CirMgr::printMemory() const
+{
+	size_t bytes, numGates;
+	if(_compact)
 	{
-		dfs(_POs[i], cnt, 'c', outfile);
+		bytes = _compact->getMemUsage();
+		numGates = _compact->getNumGates();
 	}
-	outfile << "aag " << _maxId - _POs.size() - 1 << " " << _PIs.size() << " 0 " << _POs.size() << " " << cnt << endl;
+	else
+	{
+		bytes = sizeof(*this) + _arena.getAllocSize() + (_PIs.capacity() +
+			_POs.capacity() + _AIGs.capacity()) * sizeof(CirGate*) +
+			(_float.capacity() + _unused.capacity()) * sizeof(unsigned);
+		numGates = _PIs.size() + _POs.size() + _AIGs.size() - _deleted.size();
+	}
+	ios_base::fmtflags f = cout.flags();
+	streamsize prec = cout.precision();
+	cout << "Storage: " << (_compact? "compact": "gates") << ", " << bytes
+		<< " Bytes";
+	if(numGates)
+		cout << " (" << fixed << setprecision(1) << double(bytes) / numGates
+			<< " Bytes per gate)";
+	cout << endl;
+	cout.flags(f);
+	cout.precision(prec);
+}
+
+void
+CirMgr::reportGate(unsigned gid, ostream& os) const
+{
+	if(_compact)
+		_compact->reportGate(gid, os);
+	else
+		_gates[gid]->reportGate(os);
+}
+
+void
+CirMgr::reportFanin(unsigned gid, int level, ostream& os) const
+{
+	if(_compact)
+		_compact->reportFanin(gid, level, os);
+	else
+		_gates[gid]->reportFanin(level, os);
+}
+
+void
+CirMgr::reportFanout(unsigned gid, int level, ostream& os) const
+{
+	if(_compact)
+		_compact->reportFanout(gid, level, os);
+	else
+		_gates[gid]->reportFanout(level, os);
+}
+
+void
+CirMgr::writeAag(ostream& outfile) const
+{
+	if(_compact)
+		return _compact->writeAag(outfile);
+	const GateList& dfsList = getDfsList();
+	// The AIGs added by addAnd() have IDs above the POs
+	unsigned cnt = 0, m = _maxId - _POs.size() - 1;
+	for(size_t n = 0; n < dfsList.size(); ++n)
+		if(dfsList[n]->getType() == AIG_GATE)
+		{
+			++cnt;
+			m = max(m, dfsList[n]->getId());
+		}
+	outfile << "aag " << m << " " << _PIs.size() << " 0 " << _POs.size() << " " << cnt << endl;
 	for(size_t i = 0; i < _PIs.size(); ++i)
 		outfile << _PIs[i]->getId() * 2 << endl;
 	for(size_t i = 0; i < _POs.size(); ++i)
 		outfile << _POs[i]->getFaninId(0) << endl;
-	CirGate::setGlobalRef();
-	for(size_t i = 0; i < _POs.size(); ++i)
+	for(size_t n = 0; n < dfsList.size(); ++n)
 	{
-		dfs(_POs[i], cnt, 'w', outfile);
+		const CirGate* g = dfsList[n];
+		if(g->getType() == AIG_GATE)
+			outfile << g->getId() * 2 << " " << g->getFaninId(0) << " " << g->getFaninId(1) << endl;
 	}
 	for(size_t i = 0; i < _PIs.size(); ++i)
 		if(_PIs[i]->getSymbol() != "")
@@ -1151,48 +1743,109 @@ CirMgr::writeAag(ostream& outfile) const
 }
 
 
-void
-CirMgr::dfs(const CirGate* g, unsigned &cnt, const char &usage, ostream& os) const
+// The PIs and the AIGs in the DFS order from the POs are renumbered to
+// 1..I and I+1..I+A, so that an AIG is bigger than its fanins. Return
+// false (and write nothing) if there are floating fanins, which binary
+// AIGER cannot express.
+bool
+CirMgr::writeAig(ostream& outfile) const
 {
-	// Print netList
-	for(size_t i = 0; i < g->getFaninIdSize(); ++i)
+	if(_compact)
+		return _compact->writeAig(outfile);
+	const GateList& dfsList = getDfsList();
+	GateList aigs;
+	for(size_t n = 0; n < dfsList.size(); ++n)
 	{
-		if(g->getFaninPin(i).gate())
-		{
-			if(!g->getFaninPin(i).gate()->isGlobalRef())
-			{
-				g->getFaninPin(i).gate()->setToGlobalRef();
-				dfs(g->getFaninPin(i).gate(), cnt, usage, os);
-			}
-		}
-	}
-	if(usage == 'n')
-	{
-		os << "[" << cnt << "] " << setw(4) << left << g->getTypeStr() << g->getId();
+		const CirGate* g = dfsList[n];
 		for(size_t i = 0; i < g->getFaninIdSize(); ++i)
-		{
-			os << " ";
 			if(!g->getFaninPin(i).gate())
-				os << "*";
-			if(g->getFaninId(i) % 2 != 0)
-				os << "!";
-			os << g->getFaninId(i) / 2 ;
-		}
-		if(g->getSymbol() != "")
-			os << " (" << g->getSymbol() << ")";
-		os << endl;
-		++cnt;
+				return false;
+		if(g->getType() == AIG_GATE)
+			aigs.push_back((CirGate*)g);
 	}
-	else if(usage == 'c')
+	IdList newId(_maxId, 0);
+	for(size_t i = 0; i < _PIs.size(); ++i)
+		newId[_PIs[i]->getId()] = i + 1;
+	for(size_t i = 0; i < aigs.size(); ++i)
+		newId[aigs[i]->getId()] = _PIs.size() + i + 1;
+
+	outfile << "aig " << _PIs.size() + aigs.size() << " " << _PIs.size() << " 0 " << _POs.size() << " " << aigs.size() << "\n";
+	for(size_t i = 0; i < _POs.size(); ++i)
 	{
-		if(g->getTypeStr() != "PI" && g->getTypeStr() != "PO" && g->getTypeStr() != "CONST")
-			++cnt;
+		unsigned fanInId = _POs[i]->getFaninId(0);
+		outfile << newId[fanInId / 2] * 2 + fanInId % 2 << "\n";
 	}
-	else if(usage == 'w')
+	for(size_t i = 0; i < aigs.size(); ++i)
 	{
-		if(g->getTypeStr() == "AIG")
+		unsigned lhs = newId[aigs[i]->getId()] * 2;
+		unsigned rhs0 = newId[aigs[i]->getFaninId(0) / 2] * 2 + aigs[i]->getFaninId(0) % 2;
+		unsigned rhs1 = newId[aigs[i]->getFaninId(1) / 2] * 2 + aigs[i]->getFaninId(1) % 2;
+		if(rhs0 < rhs1)
+			swap(rhs0, rhs1);
+		writeDelta(outfile, lhs - rhs0);
+		writeDelta(outfile, rhs0 - rhs1);
+	}
+	for(size_t i = 0; i < _PIs.size(); ++i)
+		if(_PIs[i]->getSymbol() != "")
+			outfile << "i" << i << " " << _PIs[i]->getSymbol() << "\n";
+	for(size_t i = 0; i < _POs.size(); ++i)
+		if(_POs[i]->getSymbol() != "")
+			outfile << "o" << i << " " << _POs[i]->getSymbol() << "\n";
+	outfile << "c" << "\n";
+	outfile << "finally it comes to an end (TAT)" << endl;
+	return true;
+}
+
+// Iterative DFS from the POs with an explicit stack of (gate, index of
+// the next fanin to visit), so that deep circuits do not overflow the
+// call stack; the order is the same as that of the recursive one
+void
+CirMgr::buildDfsList() const
+{
+	_dfsList.clear();
+	_dfsList.reserve(_PIs.size() + _POs.size() + _AIGs.size() + 1);
+	_dfsPos.assign(_maxId, NO_DFS_POS);
+	_dfsHoles = 0;
+	vector<pair<const CirGate*, unsigned> > stack;
+	CirGate::setGlobalRef();
+	for(size_t i = 0; i < _POs.size(); ++i)
+	{
+		stack.push_back(make_pair(_POs[i], 0u));
+		while(!stack.empty())
 		{
-			os << g->getId() * 2 << " " << g->getFaninId(0) << " " << g->getFaninId(1) << endl;
+			const CirGate* g = stack.back().first;
+			unsigned& next = stack.back().second;
+			if(next < g->getFaninIdSize())
+			{
+				CirGate* fanIn = g->getFaninPin(next++).gate();
+				if(fanIn && !fanIn->isGlobalRef())
+				{
+					fanIn->setToGlobalRef();
+					stack.push_back(make_pair(fanIn, 0u));
+				}
+			}
+			else
+			{
+				_dfsPos[g->getId()] = _dfsList.size();
+				_dfsList.push_back((CirGate*)g);
+				stack.pop_back();
+			}
 		}
 	}
-}
\ No newline at end of file
+	_dfsDone = true;
+}
+
+// Drop the holes left in _dfsList by the netlist edits
+void
+CirMgr::fillDfsHoles() const
+{
+	size_t n = 0;
+	for(size_t i = 0; i < _dfsList.size(); ++i)
+		if(_dfsList[i])
+		{
+			_dfsPos[_dfsList[i]->getId()] = n;
+			_dfsList[n++] = _dfsList[i];
+		}
+	_dfsList.resize(n);
+	_dfsHoles = 0;
+}
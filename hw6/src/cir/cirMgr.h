@@ -13,45 +13,117 @@
 #include <string>
 #include <fstream>
 #include <iostream>
+#include <stdint.h>
 
 using namespace std;
 
 #include "cirDef.h"
 #include "cirGate.h"
+#include "cirCompact.h"
+#include "myPool.h"
 
 extern CirMgr *cirMgr;
 
+class SatSolver;
+
+// Simulation values are in blocks of SIM_WORDS words per gate
+#define SIM_WORDS    8
+#define SIM_PATTERNS (SIM_WORDS * 64)
+
+// A kernel evaluates 'n' AIGs: AIG i takes the slot literals f[2i] and
+// f[2i+1] and writes the SIM_WORDS words at out + i * SIM_WORDS. The
+// values are slot-major in 'v'; 'out' follows all the fanin slots.
+typedef void (*SimKernel)(const uint64_t* v, const unsigned* f,
+                          uint64_t* out, size_t n);
+
+// How the simulation is split over the threads (see simBlocks())
+enum SimPartition
+{
+   SIM_BLOCKS = 0,   // by pattern blocks
+   SIM_LEVELS = 1    // by the AIGs within each level
+};
+
 // TODO: Define your own data members and member functions
 class CirMgr
 {
 public:
-   CirMgr():_gates(0) { _const = new Const0();}
-   ~CirMgr()
-   {
-   	delete _const;
-   	delete _gates;
-   	for(int i = 0; i < _PIs.size(); ++i)
-   		delete _PIs[i];
-   	_PIs.shrink_to_fit();
-   	for(int i = 0; i < _POs.size(); ++i)
-   		delete _POs[i];
-   	_POs.shrink_to_fit();
-   	for(int i = 0; i < _AIGs.size(); ++i)
-   		delete _AIGs[i];
-   	_AIGs.shrink_to_fit();
-   }
+   CirMgr():_numThreads(1), _gatePool(_arena), _gates(0), _gatesCap(0), _listsDirty(false), _batchEdits(false), _compact(0), _dfsDone(false), _dfsHoles(0), _simLog(0), _fecInit(false) { _const = _gatePool.create<Const0>();}
+   // The gates, their fanout lists and symbols, and _gates are all in
+   // _arena, which is freed at once
+   ~CirMgr() { delete _compact; }
 
    // Access functions
-   // return '0' if "gid" corresponds to an undefined gate.
+   // return '0' if "gid" corresponds to an undefined gate, or if the
+   // circuit is compact (see compact())
    CirGate* getGate(unsigned gid) const
    {
-   	if(gid <= _maxId)
+   	if(_gates && gid < _maxId)
    		return _gates[gid];
    	return 0;
    }
+   bool hasGate(unsigned gid) const
+   {
+   	return _compact? _compact->hasGate(gid): getGate(gid) != 0;
+   }
+   bool isCompact() const { return _compact; }
 
    // Member functions about circuit construction
+   // #threads used by readCircuit() and the simulation
+   void setNumThreads(unsigned t) { _numThreads = t? t: 1; }
    bool readCircuit(const string&);
+   // Move the circuit into the struct-of-arrays CirCompact and free the
+   // gates; only the reporting and writing functions work on it
+   void compact();
+
+   // Member functions about simulation
+   // Simulate SIM_PATTERNS patterns at a time on the AIGs of
+   // getDfsList() with the fastest SIMD kernel of the CPU, on the
+   // threads set by setNumThreads(); each pattern is written to the log
+   // file if set (see writeSimLog())
+   void randomSim();
+   void fileSim(ifstream&);
+   void benchSim();
+   void setSimLog(ofstream *logFile) { _simLog = logFile; }
+
+   // Member functions about circuit optimization
+   // Remove the AIGs not reachable from the POs
+   void sweep();
+   // Fold the AIGs with a constant fanin, or with identical or inverse
+   // fanins, into a fanin or CONST0
+   void optimize();
+   // Merge the AIGs with the same (unordered) fanin literals
+   void strash();
+   // Prove the FEC candidates of the last simulation with the SAT
+   // solver and merge the equivalent ones
+   void fraig();
+
+   // Member functions about netlist editing
+   // Each edit keeps the fanout lists, the levels and the level lists
+   // (once built) up to date at a cost in the size of the fanout cone
+   // whose levels change, and the DFS order in the cone whose order or
+   // reachability changes (see getDfsList()). strash(), optimize() and
+   // fraig() merge gates with replaceGate(), and drop the levels first.
+   // An illegal edit returns false (0 for addAnd()) and changes nothing.
+   // Add an AIG of two literals of existing gates; return its ID
+   unsigned addAnd(unsigned lit0, unsigned lit1);
+   // Set fanin 'i' of the AIG or PO 'gid' to literal 'lit', unless that
+   // makes a cycle
+   bool replaceFanin(unsigned gid, size_t i, unsigned lit);
+   // Move the fanouts of the AIG 'gid' to literal 'lit', unless that
+   // makes a cycle, and delete the AIG
+   bool replaceGate(unsigned gid, unsigned lit);
+   // Delete the AIG 'gid', which must have no fanouts
+   bool deleteGate(unsigned gid);
+   // The level of a gate is 0 for CONST0 and the PIs, and otherwise 1 +
+   // that of its highest fanin (0 for a floating one); the gates of each
+   // level, listed by level, are thus in topological order
+   unsigned getLevel(unsigned gid) const;
+   const vector<IdList>& getLevelList() const;
+
+   // Member functions about equivalence checking
+   // Check the POs against those of 'other' (see cirFraig.cpp); the
+   // counter-examples are written to 'patternFile', or printed if 0
+   void checkEquiv(const CirMgr& other, ostream* patternFile) const;
 
    // Member functions about circuit reporting
    void printSummary() const;
@@ -59,20 +131,137 @@ public:
    void printPIs() const;
    void printPOs() const;
    void printFloatGates() const;
+   void printMemory() const;
+   void printFECPairs() const;
+   void reportGate(unsigned gid, ostream&) const;
+   void reportFanin(unsigned gid, int level, ostream&) const;
+   void reportFanout(unsigned gid, int level, ostream&) const;
    void writeAag(ostream&) const;
+   bool writeAig(ostream&) const;
 
    // Dfs traversal
-	void dfs(const CirGate* g, unsigned &cnt, const char &usage, ostream& os) const;
+   // The gates reachable from the POs in DFS post-order (fanins before
+   // fanouts, POs in order); floating fanins are skipped. It is built at
+   // the first call; the netlist edits then keep it a topological order
+   // of the reachable gates, which may no longer be the DFS post-order.
+   const GateList& getDfsList() const
+   {
+   	if(!_dfsDone)
+   		buildDfsList();
+   	else if(_dfsHoles)
+   		fillDfsHoles();
+   	return _dfsList;
+   }
 
 private:
+	bool readCircuitMapped(const string&, bool&);
+	bool parseMapped(const char*, const char*);
+	bool parseMappedSymbols(const char*&, const char*, bool);
+	bool parseAig(const char*, const char*);
+	void buildDfsList() const;
+	void fillDfsHoles() const;
+	// Call it whenever gates or connections are changed
+	// (and the simulation program built from getDfsList())
+	void invalidateDfsList()
+	{
+		_dfsList.clear();
+		_dfsDone = false;
+		_dfsHoles = 0;
+		invalidateSim();
+	}
+	// Call it instead if getDfsList() has been kept up to date
+	void invalidateSim()
+	{
+		_simIds.clear();
+		_fecGrps.clear();
+		_fecInit = false;
+	}
+	// Netlist editing (see cirOpt.cpp)
+	void mergeGate(CirGate*, CirGate*, bool);
+	void purgeGates(const GateList&);
+	void flushDeleted();
+	void tidyGateLists() const;
+	CirGate* editFanin(unsigned) const;
+	bool reaches(CirGate*, CirGate*) const;
+	void addFanout(CirGate*, const pin&);
+	void removeFanout(CirGate*, const pin&);
+	bool inDfs(const CirGate*) const;
+	void setDfsPos(CirGate*, unsigned);
+	void dropFromDfs(CirGate*);
+	void dfsAddFanin(const GateList&, CirGate*, unsigned);
+	void dfsDropUnreached(const GateList&);
+	void buildLevels() const;
+	void invalidateLevels() { _level.clear(); }
+	unsigned faninLevel(const CirGate*) const;
+	void setLevel(unsigned, unsigned) const;
+	void updateLevels(const IdList&);
+	void buildSimProg();
+	SimPartition pickSimPartition(size_t, unsigned) const;
+	bool wideSimLevels(unsigned) const;
+	void simBlocks(const vector<uint64_t>&, size_t, size_t, SimPartition,
+	               unsigned, vector<uint64_t>* = 0, bool = true);
+	void refineFecGrps(uint64_t* const*, size_t);
+	size_t numFecGates() const;
+	void simulate(uint64_t*, SimKernel) const;
+	void getSimPo(const uint64_t*, uint64_t*) const;
+	void writeSimLog(const uint64_t*, const uint64_t*, size_t) const;
+	void randomSimPo(size_t, vector<string>&);
+	void initSatVars(SatSolver&, IdList&) const;
+	unsigned satVar(SatSolver&, IdList&, unsigned) const;
+	void buildMiter(const CirMgr&, const CirMgr&, const IdList&, const IdList&);
+	void connectCircuit();
+	void resetCircuit();
+
+	unsigned		_numThreads;	// for reading
+	MyArena		_arena;
+	MyPool<CirGate>	_gatePool;
 	CirGate*		_const;
    GateList		_PIs;
    GateList		_POs;
    GateList		_AIGs;
    CirGate**	_gates;
-   IdList		_float;
-   IdList		_unused;
+   unsigned		_gatesCap;	// 0 if _gates has no room to grow
+   // Sorted by ID; the edits only append to them and set _listsDirty
+   // (see tidyGateLists())
+   mutable IdList	_float;
+   mutable IdList	_unused;
+   mutable bool	_listsDirty;
+   // The AIGs deleted by the edits, still in _AIGs (see flushDeleted())
+   GateList		_deleted;
+   // Set by the passes: the deleted AIGs keep the fanout pins to them,
+   // and the gates that may be no longer reachable are put in
+   // _dfsUnreached, until flushDeleted()
+   bool			_batchEdits;
+   GateList		_dfsUnreached;
    unsigned 	_maxId;
+   CirCompact*	_compact;
+   // After the edits, _dfsList may have holes (0), filled in when next
+   // read; _dfsPos is the index of a gate in it, by ID (NO_DFS_POS if
+   // not reachable)
+   static const unsigned NO_DFS_POS = ~0u;
+   mutable GateList	_dfsList;
+   mutable bool	_dfsDone;
+   mutable IdList	_dfsPos;
+   mutable size_t	_dfsHoles;
+   // Levels (see getLevel()), by gate ID; empty until built. _levelPos
+   // is the index of a gate in its level list.
+   mutable IdList	_level;
+   mutable vector<IdList>	_levelList;
+   mutable IdList	_levelPos;
+   // Simulation: the values of the gates are in slots of SIM_WORDS
+   // words (see buildSimProg()); _simFanin holds the 2 fanin slot
+   // literals of each AIG and _simPo the one of each PO
+   IdList		_simIds;			// gate ID of each slot
+   IdList		_simLevel;		// first AIG of each level
+   IdList		_simFanin;
+   IdList		_simPo;
+   vector<uint64_t>	_simValue;
+   ofstream*	_simLog;
+   // FEC groups: the slot literals (slot * 2 + phase) of CONST0 and the
+   // AIGs that have been equal or inverse on all the simulated patterns
+   // (see refineFecGrps()); _fecInit is false before the first pattern
+   vector<IdList>	_fecGrps;
+   bool			_fecInit;
 };
 
 #endif // CIR_MGR_H
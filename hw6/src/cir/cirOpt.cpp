@@ -0,0 +1,680 @@
+/****************************************************************************
+  FileName     [ cirOpt.cpp ]
+  PackageName  [ cir ]
+  Synopsis     [ Define cir optimization functions ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <algorithm>
+#include <map>
+#include <cassert>
+#include "cirMgr.h"
+#include "cirGate.h"
+#include "util.h"
+
+using namespace std;
+
+/**************************************/
+/*   Static variables and functions   */
+/**************************************/
+// Level of a deleted gate (see CirMgr::setLevel())
+static const unsigned NO_LEVEL = ~0u;
+
+// An edit that would move more than 1 / DFS_MOVE_RATIO of the DFS order
+// drops it for a rebuild instead (see CirMgr::dfsAddFanin())
+static const size_t DFS_MOVE_RATIO = 8;
+
+/**************************************************/
+/*   Public member functions about optimization   */
+/**************************************************/
+// The DFS order is the set of reachable gates; remove the other AIGs
+// (the PIs are kept)
+void
+CirMgr::sweep()
+{
+   chrono::steady_clock::time_point start = chrono::steady_clock::now();
+   flushDeleted();
+   size_t numAIGs = _AIGs.size();
+   const GateList& dfsList = getDfsList();
+   vector<bool> reached(_maxId, false);
+   for (size_t n = 0; n < dfsList.size(); ++n)
+      reached[dfsList[n]->getId()] = true;
+   GateList removed;
+   for (size_t i = 0; i < _AIGs.size(); ++i)
+      if (!reached[_AIGs[i]->getId()])
+         removed.push_back(_AIGs[i]);
+   purgeGates(removed);
+   chrono::duration<double> d = chrono::steady_clock::now() - start;
+   cout << "Sweeping: " << removed.size() << " AIG(s) removed, AIGs "
+        << numAIGs << " -> " << _AIGs.size() << ", in " << setprecision(4)
+        << d.count() << " seconds" << endl;
+}
+
+// Go through the AIGs in DFS order, so the fanins of an AIG have been
+// folded before it is. An AIG becomes
+//    CONST0 if a fanin is CONST0 or the fanins are inverse;
+//    the other fanin if a fanin is CONST1;
+//    the fanin if the fanins are identical.
+// A fanin that is not defined is never merged into. Gates that are no
+// longer reachable are left to sweep().
+void
+CirMgr::optimize()
+{
+   chrono::steady_clock::time_point start = chrono::steady_clock::now();
+   flushDeleted();
+   // Built again when next needed, as keeping them costs more over a pass
+   invalidateLevels();
+   _batchEdits = true;
+   size_t numAIGs = _AIGs.size();
+   // A copy, as replaceGate() moves gates in the DFS order
+   GateList dfsList(getDfsList());
+   size_t numFolded = 0;
+   for (size_t n = 0; n < dfsList.size(); ++n) {
+      CirGate* g = dfsList[n];
+      if (g->getType() != AIG_GATE) continue;
+      unsigned a = g->getFaninId(0), b = g->getFaninId(1);
+      // A constant fanin, if any, goes to 'a'; then 'b' is the literal
+      // to merge into
+      if (b < 2) swap(a, b);
+      if (a == 0 || (a ^ b) == 1)
+         b = 0;
+      else if (a != 1 && a != b)
+         continue;
+      if (!_gates[b / 2]) continue;
+      if (replaceGate(g->getId(), b)) ++numFolded;
+   }
+   flushDeleted();
+   chrono::duration<double> d = chrono::steady_clock::now() - start;
+   cout << "Optimizing: " << numFolded << " AIG(s) folded, AIGs "
+        << numAIGs << " -> " << _AIGs.size() << ", in " << setprecision(4)
+        << d.count() << " seconds" << endl;
+}
+
+/*****************************************************/
+/*   Public member functions about netlist editing   */
+/*****************************************************/
+unsigned
+CirMgr::addAnd(unsigned lit0, unsigned lit1)
+{
+   CirGate* f[2] = { editFanin(lit0), editFanin(lit1) };
+   if (!f[0] || !f[1]) return 0;
+   // The new IDs follow the POs; _gates grows like a vector
+   if (_maxId >= _gatesCap) {
+      _gatesCap = 2 * _maxId;
+      CirGate** gates = _arena.allocArr<CirGate*>(_gatesCap);
+      copy(_gates, _gates + _maxId, gates);
+      fill(gates + _maxId, gates + _gatesCap, (CirGate*)0);
+      _gates = gates;
+   }
+   unsigned id = _maxId++;
+   CirGate* g = _gatePool.create<AIG>(0, id);
+   _gates[id] = g;
+   unsigned lits[2] = { lit0, lit1 };
+   for (size_t i = 0; i < 2; ++i) {
+      g->addFaninId(lits[i]);
+      g->setFaninPin(i, pin(f[i], lits[i] % 2));
+      addFanout(f[i], pin(g, lits[i] % 2));
+   }
+   _AIGs.push_back(g);
+   _unused.push_back(id);
+   if (!_level.empty()) {
+      unsigned l = faninLevel(g);
+      if (l >= _levelList.size()) _levelList.resize(l + 1);
+      _level.push_back(l);
+      _levelPos.push_back(_levelList[l].size());
+      _levelList[l].push_back(id);
+   }
+   // Not reachable from the POs yet, so the DFS order stays
+   return id;
+}
+
+bool
+CirMgr::replaceFanin(unsigned gid, size_t i, unsigned lit)
+{
+   CirGate* g = getGate(gid), * f = editFanin(lit);
+   if (!g || !f || i >= g->getFaninIdSize() ||
+       (g->getType() != AIG_GATE && g->getType() != PO_GATE))
+      return false;
+   if (g->getType() == AIG_GATE && reaches(g, f)) return false;
+   pin old = g->getFaninPin(i);
+   if (old.gate())
+      removeFanout(old.gate(), pin(g, old.isInv()));
+   else
+      _listsDirty = true;   // It may have had its last floating fanin
+   g->setFaninPin(i, pin(f, lit % 2));
+   g->setFaninId(i, lit);
+   addFanout(f, pin(g, lit % 2));
+   updateLevels(IdList(1, gid));
+   if (inDfs(g)) {
+      dfsAddFanin(GateList(1, g), f, NO_DFS_POS);
+      if (old.gate()) dfsDropUnreached(GateList(1, old.gate()));
+      invalidateSim();
+   }
+   return true;
+}
+
+bool
+CirMgr::replaceGate(unsigned gid, unsigned lit)
+{
+   CirGate* g = getGate(gid), * r = editFanin(lit);
+   if (!g || !r || g->getType() != AIG_GATE) return false;
+   if (reaches(g, r)) return false;
+   GateList fanouts;
+   IdList ids;
+   for (unsigned j = 0, n = g->getFanoutPinSize(); j < n; ++j) {
+      fanouts.push_back(g->getFanoutPin(j).gate());
+      ids.push_back(fanouts.back()->getId());
+   }
+   // 'r' may take the place of 'g' in the DFS order
+   unsigned slot = NO_DFS_POS;
+   if (inDfs(g)) {
+      slot = _dfsPos[gid];
+      dropFromDfs(g);
+   }
+   if (!r->getFanoutPinSize() && !fanouts.empty()) _listsDirty = true;
+   mergeGate(g, r, lit % 2);
+   g->filterFanoutPins([](const pin&) { return false; });
+   updateLevels(ids);
+   if (slot != NO_DFS_POS) {
+      dfsAddFanin(fanouts, r, slot);
+      GateList fanins;
+      for (size_t i = 0; i < 2; ++i)
+         if (g->getFaninPin(i).gate())
+            fanins.push_back(g->getFaninPin(i).gate());
+      dfsDropUnreached(fanins);
+      invalidateSim();
+   }
+   return deleteGate(gid);
+}
+
+bool
+CirMgr::deleteGate(unsigned gid)
+{
+   CirGate* g = getGate(gid);
+   if (!g || g->getType() != AIG_GATE || g->getFanoutPinSize()) return false;
+   // Each removal is linear in the fanouts, so a pass leaves them all
+   // to flushDeleted()
+   if (!_batchEdits)
+      for (size_t i = 0; i < 2; ++i) {
+         pin p = g->getFaninPin(i);
+         if (p.gate()) removeFanout(p.gate(), pin(g, p.isInv()));
+      }
+   _listsDirty = true;
+   if (!_level.empty()) setLevel(gid, NO_LEVEL);
+   _gates[gid] = 0;
+   // Taken out of _AIGs and freed by flushDeleted()
+   _deleted.push_back(g);
+   // It had no fanouts, so it was not in the DFS order
+   return true;
+}
+
+unsigned
+CirMgr::getLevel(unsigned gid) const
+{
+   if (!getGate(gid)) return 0;
+   buildLevels();
+   return _level[gid];
+}
+
+const vector<IdList>&
+CirMgr::getLevelList() const
+{
+   buildLevels();
+   return _levelList;
+}
+
+/**************************************************/
+/*   Private member functions about netlist edits  */
+/**************************************************/
+// Move the fanouts of 'g' to 'r', inverted if 'inv'. 'g' keeps its
+// fanins and the fanout pins to it (see replaceGate()).
+void
+CirMgr::mergeGate(CirGate* g, CirGate* r, bool inv)
+{
+   assert(g != r);
+   for (unsigned j = 0, n = g->getFanoutPinSize(); j < n; ++j) {
+      pin p = g->getFanoutPin(j);
+      CirGate* fo = p.gate();
+      // An AIG with both fanins from 'g' has a pin for each of them
+      for (size_t i = 0; i < fo->getFaninIdSize(); ++i) {
+         pin f = fo->getFaninPin(i);
+         if (f.gate() != g || f.isInv() != p.isInv()) continue;
+         bool phase = p.isInv() != inv;
+         fo->setFaninPin(i, pin(r, phase));
+         fo->setFaninId(i, r->getId() * 2 + phase);
+         r->addFanoutPin(_arena, pin(fo, phase));
+         break;
+      }
+   }
+}
+
+// Remove the gates in 'gates', whose fanouts have all been moved, in one
+// pass over the circuit: drop the fanout pins to them, take them out of
+// _AIGs, _float and the DFS order (which stays topological), and collect
+// the unused gates again
+void
+CirMgr::purgeGates(const GateList& gates)
+{
+   if (gates.empty()) return;
+   flushDeleted();
+   vector<bool> dead(_maxId, false);
+   for (size_t i = 0; i < gates.size(); ++i) {
+      dead[gates[i]->getId()] = true;
+      _gates[gates[i]->getId()] = 0;
+   }
+   for (size_t j = 0; j < _maxId; ++j)
+      if (_gates[j])
+         _gates[j]->filterFanoutPins([&](const pin& p) {
+            return !dead[p.gate()->getId()]; });
+
+   size_t n = 0;
+   for (size_t i = 0; i < _AIGs.size(); ++i)
+      if (!dead[_AIGs[i]->getId()]) _AIGs[n++] = _AIGs[i];
+   _AIGs.resize(n);
+   n = 0;
+   for (size_t i = 0; i < _float.size(); ++i)
+      if (!dead[_float[i]]) _float[n++] = _float[i];
+   _float.resize(n);
+   n = 0;
+   for (size_t i = 0; i < _dfsList.size(); ++i)
+      if (_dfsList[i] && !dead[_dfsList[i]->getId()]) {
+         _dfsPos[_dfsList[i]->getId()] = n;
+         _dfsList[n++] = _dfsList[i];
+      }
+   _dfsList.resize(n);
+   _dfsHoles = 0;
+   // The PIs and AIGs without fanouts are unused
+   _unused.clear();
+   for (size_t j = 1; j < _maxId; ++j)
+      if (_gates[j] && _gates[j]->getType() != PO_GATE &&
+          !_gates[j]->getFanoutPinSize())
+         _unused.push_back(j);
+
+   for (size_t i = 0; i < gates.size(); ++i)
+      _gatePool.destroy(gates[i]);
+   invalidateSim();
+   invalidateLevels();
+}
+
+// Take the AIGs deleted by the edits out of _AIGs, keeping its order,
+// and out of the fanout lists of their fanins, filtering each list once;
+// then drop the gates in _dfsUnreached that are no longer reachable, and
+// free the deleted AIGs
+void
+CirMgr::flushDeleted()
+{
+   _batchEdits = false;
+   if (_deleted.empty() && _dfsUnreached.empty()) return;
+   CirGate::setGlobalRef();
+   GateList fanins;
+   for (size_t i = 0; i < _deleted.size(); ++i) {
+      _deleted[i]->setToGlobalRef();
+      for (size_t j = 0; j < 2; ++j)
+         if (_deleted[i]->getFaninPin(j).gate())
+            fanins.push_back(_deleted[i]->getFaninPin(j).gate());
+   }
+   size_t n = 0;
+   for (size_t i = 0; i < _AIGs.size(); ++i)
+      if (!_AIGs[i]->isGlobalRef()) _AIGs[n++] = _AIGs[i];
+   _AIGs.resize(n);
+   sort(fanins.begin(), fanins.end());
+   fanins.erase(unique(fanins.begin(), fanins.end()), fanins.end());
+   for (size_t i = 0; i < fanins.size(); ++i) {
+      CirGate* f = fanins[i];
+      if (f->isGlobalRef()) continue;
+      unsigned m = f->getFanoutPinSize();
+      f->filterFanoutPins([](const pin& p) { return !p.gate()->isGlobalRef(); });
+      if (m && !f->getFanoutPinSize() &&
+          (f->getType() == PI_GATE || f->getType() == AIG_GATE)) {
+         _unused.push_back(f->getId());
+         _listsDirty = true;
+      }
+   }
+   GateList unreached;
+   unreached.swap(_dfsUnreached);
+   dfsDropUnreached(unreached);
+   for (size_t i = 0; i < _deleted.size(); ++i)
+      _gatePool.destroy(_deleted[i]);
+   _deleted.clear();
+}
+
+// Sort _float and _unused again after the edits, without the IDs that
+// no longer belong in them
+void
+CirMgr::tidyGateLists() const
+{
+   if (!_listsDirty) return;
+   IdList* lists[2] = { &_float, &_unused };
+   for (size_t k = 0; k < 2; ++k) {
+      IdList& ids = *lists[k];
+      sort(ids.begin(), ids.end());
+      ids.erase(unique(ids.begin(), ids.end()), ids.end());
+      size_t n = 0;
+      for (size_t i = 0; i < ids.size(); ++i) {
+         const CirGate* g = getGate(ids[i]);
+         if (!g) continue;
+         bool keep = false;
+         if (k == 0) {
+            for (size_t j = 0; j < g->getFaninIdSize(); ++j)
+               if (!g->getFaninPin(j).gate()) keep = true;
+         }
+         else
+            keep = g->getType() != PO_GATE && !g->getFanoutPinSize();
+         if (keep) ids[n++] = ids[i];
+      }
+      ids.resize(n);
+   }
+   _listsDirty = false;
+}
+
+// The gate of literal 'lit' if it can be a fanin
+CirGate*
+CirMgr::editFanin(unsigned lit) const
+{
+   CirGate* g = getGate(lit / 2);
+   return (g && g->getType() != PO_GATE)? g: 0;
+}
+
+// Whether 'to' is 'from' or in its fanout cone. It is not if 'to' has no
+// fanins or comes before 'from' in the DFS order; otherwise, as the
+// levels rise along a path, only the gates below the level of 'to' are
+// searched.
+bool
+CirMgr::reaches(CirGate* from, CirGate* to) const
+{
+   if (from == to) return true;
+   if (!to->getFaninIdSize()) return false;
+   if (inDfs(from) && inDfs(to) &&
+       _dfsPos[to->getId()] < _dfsPos[from->getId()])
+      return false;
+   buildLevels();
+   unsigned l = _level[to->getId()];
+   GateList stack(1, from);
+   CirGate::setGlobalRef();
+   from->setToGlobalRef();
+   while (!stack.empty()) {
+      CirGate* g = stack.back();
+      stack.pop_back();
+      for (unsigned j = 0, n = g->getFanoutPinSize(); j < n; ++j) {
+         CirGate* fo = g->getFanoutPin(j).gate();
+         if (fo == to) return true;
+         if (fo->isGlobalRef() || _level[fo->getId()] >= l) continue;
+         fo->setToGlobalRef();
+         stack.push_back(fo);
+      }
+   }
+   return false;
+}
+
+// Add or remove a fanout pin of 'g', keeping _unused (see
+// tidyGateLists())
+void
+CirMgr::addFanout(CirGate* g, const pin& p)
+{
+   if (!g->getFanoutPinSize()) _listsDirty = true;
+   g->addFanoutPin(_arena, p);
+}
+
+void
+CirMgr::removeFanout(CirGate* g, const pin& p)
+{
+   g->removeFanoutPin(p);
+   if (!g->getFanoutPinSize() &&
+       (g->getType() == PI_GATE || g->getType() == AIG_GATE)) {
+      _unused.push_back(g->getId());
+      _listsDirty = true;
+   }
+}
+
+bool
+CirMgr::inDfs(const CirGate* g) const
+{
+   unsigned id = g->getId();
+   return _dfsDone && id < _dfsPos.size() && _dfsPos[id] != NO_DFS_POS;
+}
+
+// Put 'g' at index 'k' of the DFS order
+void
+CirMgr::setDfsPos(CirGate* g, unsigned k)
+{
+   if (g->getId() >= _dfsPos.size()) _dfsPos.resize(_maxId, NO_DFS_POS);
+   _dfsList[k] = g;
+   _dfsPos[g->getId()] = k;
+}
+
+// Leave a hole in place of 'g' in the DFS order
+void
+CirMgr::dropFromDfs(CirGate* g)
+{
+   _dfsList[_dfsPos[g->getId()]] = 0;
+   _dfsPos[g->getId()] = NO_DFS_POS;
+   ++_dfsHoles;
+}
+
+// The gates 'fanouts' have got the fanin 'f'. If one of them is in the
+// DFS order, 'f' must come before them and its fanin cone is reachable:
+// 'f' goes to the hole 'slot' (NO_DFS_POS if none) if its fanins are all
+// before it; otherwise the unlisted fanin cone of 'f', in DFS post-order,
+// is appended, followed by the listed fanout cone of 'fanouts' in its
+// old order.
+void
+CirMgr::dfsAddFanin(const GateList& fanouts, CirGate* f, unsigned slot)
+{
+   unsigned first = NO_DFS_POS;
+   for (size_t i = 0; i < fanouts.size(); ++i)
+      if (inDfs(fanouts[i]))
+         first = min(first, _dfsPos[fanouts[i]->getId()]);
+   if (first == NO_DFS_POS) return;
+   if (inDfs(f) && _dfsPos[f->getId()] < first) return;
+   if (slot < first) {
+      bool fits = true;
+      for (size_t i = 0; i < f->getFaninIdSize(); ++i) {
+         const CirGate* fanIn = f->getFaninPin(i).gate();
+         if (fanIn && (!inDfs(fanIn) || _dfsPos[fanIn->getId()] > slot))
+            fits = false;
+      }
+      if (fits) {
+         if (inDfs(f)) dropFromDfs(f);
+         setDfsPos(f, slot);
+         --_dfsHoles;
+         return;
+      }
+   }
+
+   size_t limit = _dfsList.size() / DFS_MOVE_RATIO;
+   GateList cone;
+   vector<pair<CirGate*, unsigned> > stack;
+   CirGate::setGlobalRef();
+   if (!inDfs(f)) {
+      f->setToGlobalRef();
+      stack.push_back(make_pair(f, 0u));
+   }
+   while (!stack.empty()) {
+      CirGate* g = stack.back().first;
+      unsigned& next = stack.back().second;
+      if (next < g->getFaninIdSize()) {
+         CirGate* fanIn = g->getFaninPin(next++).gate();
+         if (fanIn && !inDfs(fanIn) && !fanIn->isGlobalRef()) {
+            fanIn->setToGlobalRef();
+            stack.push_back(make_pair(fanIn, 0u));
+         }
+         continue;
+      }
+      cone.push_back(g);
+      stack.pop_back();
+   }
+   GateList moved;
+   for (size_t i = 0; i < fanouts.size(); ++i)
+      if (inDfs(fanouts[i]) && !fanouts[i]->isGlobalRef()) {
+         fanouts[i]->setToGlobalRef();
+         moved.push_back(fanouts[i]);
+      }
+   for (size_t k = 0; k < moved.size(); ++k) {
+      if (cone.size() + moved.size() > limit) {
+         invalidateDfsList();
+         return;
+      }
+      for (unsigned j = 0, n = moved[k]->getFanoutPinSize(); j < n; ++j) {
+         CirGate* fo = moved[k]->getFanoutPin(j).gate();
+         if (!inDfs(fo) || fo->isGlobalRef()) continue;
+         fo->setToGlobalRef();
+         moved.push_back(fo);
+      }
+   }
+   if (cone.size() + moved.size() > limit) {
+      invalidateDfsList();
+      return;
+   }
+   sort(moved.begin(), moved.end(), [&](CirGate* a, CirGate* b) {
+      return _dfsPos[a->getId()] < _dfsPos[b->getId()]; });
+   for (size_t k = 0; k < moved.size(); ++k)
+      dropFromDfs(moved[k]);
+   // Compact the holes before the order grows too long
+   if (_dfsHoles > _dfsList.size() / 2) fillDfsHoles();
+   for (size_t k = 0; k < cone.size(); ++k) {
+      _dfsList.push_back(0);
+      setDfsPos(cone[k], _dfsList.size() - 1);
+   }
+   for (size_t k = 0; k < moved.size(); ++k) {
+      _dfsList.push_back(0);
+      setDfsPos(moved[k], _dfsList.size() - 1);
+   }
+}
+
+// The gates 'gates' have lost fanouts; take them, and then their fanins,
+// out of the DFS order as long as they have no fanouts left in it. The
+// fanouts of each gate are counted once, so that a gate with many
+// fanouts dropped one by one costs no more than its fanouts.
+void
+CirMgr::dfsDropUnreached(const GateList& gates)
+{
+   // Their fanout lists may still have pins to deleted AIGs
+   if (_batchEdits) {
+      _dfsUnreached.insert(_dfsUnreached.end(), gates.begin(), gates.end());
+      return;
+   }
+   map<CirGate*, unsigned> left;   // #fanout pins in the DFS order
+   GateList stack;
+   for (size_t i = 0; i < gates.size(); ++i) {
+      CirGate* g = gates[i];
+      if (!inDfs(g) || g->getType() == PO_GATE || left.count(g)) continue;
+      unsigned& n = left[g];
+      for (unsigned j = 0, m = g->getFanoutPinSize(); j < m; ++j)
+         if (inDfs(g->getFanoutPin(j).gate())) ++n;
+      if (!n) stack.push_back(g);
+   }
+   while (!stack.empty()) {
+      CirGate* g = stack.back();
+      stack.pop_back();
+      dropFromDfs(g);
+      // An AIG with both fanins from one gate counts as 2 of its fanouts
+      CirGate* fanins[2] = { 0, 0 };
+      for (size_t i = 0; i < g->getFaninIdSize(); ++i)
+         fanins[i] = g->getFaninPin(i).gate();
+      bool twice = fanins[1] && fanins[1] == fanins[0];
+      if (twice) fanins[1] = 0;
+      for (size_t i = 0; i < 2; ++i) {
+         CirGate* f = fanins[i];
+         if (!f || !inDfs(f)) continue;
+         map<CirGate*, unsigned>::iterator it = left.find(f);
+         if (it == left.end()) {
+            // Counted after 'g' is dropped
+            it = left.insert(make_pair(f, 0u)).first;
+            for (unsigned j = 0, m = f->getFanoutPinSize(); j < m; ++j)
+               if (inDfs(f->getFanoutPin(j).gate())) ++it->second;
+         }
+         else
+            it->second -= twice? 2: 1;
+         if (!it->second) stack.push_back(f);
+      }
+   }
+}
+
+// Level all the gates, the unreachable ones too, in a DFS post-order
+// from each gate in ID order
+void
+CirMgr::buildLevels() const
+{
+   if (!_level.empty() || !_gates) return;
+   _level.assign(_maxId, 0);
+   _levelPos.assign(_maxId, 0);
+   _levelList.assign(1, IdList());
+   vector<pair<const CirGate*, unsigned> > stack;
+   CirGate::setGlobalRef();
+   for (unsigned j = 0; j < _maxId; ++j) {
+      if (!_gates[j] || _gates[j]->isGlobalRef()) continue;
+      _gates[j]->setToGlobalRef();
+      stack.push_back(make_pair(_gates[j], 0u));
+      while (!stack.empty()) {
+         const CirGate* g = stack.back().first;
+         unsigned& next = stack.back().second;
+         if (next < g->getFaninIdSize()) {
+            CirGate* fanIn = g->getFaninPin(next++).gate();
+            if (fanIn && !fanIn->isGlobalRef()) {
+               fanIn->setToGlobalRef();
+               stack.push_back(make_pair(fanIn, 0u));
+            }
+            continue;
+         }
+         unsigned id = g->getId(), l = faninLevel(g);
+         if (l >= _levelList.size()) _levelList.resize(l + 1);
+         _level[id] = l;
+         _levelPos[id] = _levelList[l].size();
+         _levelList[l].push_back(id);
+         stack.pop_back();
+      }
+   }
+}
+
+unsigned
+CirMgr::faninLevel(const CirGate* g) const
+{
+   unsigned l = 0;
+   for (size_t i = 0; i < g->getFaninIdSize(); ++i) {
+      const CirGate* f = g->getFaninPin(i).gate();
+      l = max(l, (f? _level[f->getId()]: 0) + 1);
+   }
+   return l;
+}
+
+// Move gate 'gid' from its level list to that of level 'l', or just
+// take it out if 'l' is NO_LEVEL
+void
+CirMgr::setLevel(unsigned gid, unsigned l) const
+{
+   IdList& old = _levelList[_level[gid]];
+   unsigned k = _levelPos[gid];
+   old[k] = old.back();
+   _levelPos[old[k]] = k;
+   old.pop_back();
+   _level[gid] = l;
+   if (l != NO_LEVEL) {
+      if (l >= _levelList.size()) _levelList.resize(l + 1);
+      _levelPos[gid] = _levelList[l].size();
+      _levelList[l].push_back(gid);
+   }
+   while (_levelList.size() > 1 && _levelList.back().empty())
+      _levelList.pop_back();
+}
+
+// Level the gates 'ids' again, and their fanouts as long as the levels
+// change
+void
+CirMgr::updateLevels(const IdList& ids)
+{
+   if (_level.empty()) return;
+   IdList queue(ids);
+   for (size_t q = 0; q < queue.size(); ++q) {
+      const CirGate* g = _gates[queue[q]];
+      if (!g) continue;   // An AIG deleted in a pass
+      unsigned l = faninLevel(g);
+      if (l == _level[queue[q]]) continue;
+      setLevel(queue[q], l);
+      for (unsigned j = 0, n = g->getFanoutPinSize(); j < n; ++j)
+         queue.push_back(g->getFanoutPin(j).gate()->getId());
+   }
+}
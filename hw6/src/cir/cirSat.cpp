@@ -0,0 +1,508 @@
+/****************************************************************************
+  FileName     [ cirSat.cpp ]
+  PackageName  [ cir ]
+  Synopsis     [ Define the CDCL SAT solver ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2010-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#include <algorithm>
+#include <cstring>
+#include <cassert>
+#include "cirSat.h"
+
+using namespace std;
+
+/**************************************/
+/*   Static variables and functions   */
+/**************************************/
+// Conflicts between restarts are SAT_RESTART_BASE times the Luby
+// sequence 1 1 2 1 1 2 4 ...
+static const size_t SAT_RESTART_BASE = 100;
+// Learned clauses kept at least, and at least 1/SAT_LEARNT_RATIO of the
+// problem clauses; the limit grows by SAT_LEARNT_GROW at each deletion
+static const double SAT_LEARNT_MIN = 2000;
+static const double SAT_LEARNT_RATIO = 3;
+static const double SAT_LEARNT_GROW = 1.1;
+static const double SAT_VAR_DECAY = 0.95;
+static const double SAT_CLAUSE_DECAY = 0.999;
+
+static size_t
+luby(size_t i)
+{
+   // Find the finite subsequence that contains index 'i', and its size
+   size_t size = 1, seq = 0;
+   while (size < i + 1) { ++seq; size = 2 * size + 1; }
+   while (size - 1 != i) {
+      size = (size - 1) >> 1;
+      --seq;
+      i = i % size;
+   }
+   return size_t(1) << seq;
+}
+
+/*******************************/
+/*   class SatSolver methods   */
+/*******************************/
+const unsigned SatSolver::NO_REASON;
+const unsigned SatSolver::NO_LIT;
+
+SatSolver::SatSolver()
+   : _ok(true), _qhead(0), _varInc(1), _clauseInc(1),
+     _maxLearnts(SAT_LEARNT_MIN), _numConflicts(0), _numDecisions(0)
+{
+}
+
+Var
+SatSolver::newVar()
+{
+   Var v = _value.size();
+   _value.push_back(L_UNDEF);
+   _polarity.push_back(1);
+   _level.push_back(0);
+   _reason.push_back(NO_REASON);
+   _activity.push_back(0);
+   _seen.push_back(0);
+   _heapIdx.push_back(-1);
+   _watches.resize(2 * (v + 1));
+   heapInsert(v);
+   return v;
+}
+
+// Must be called at level 0, i.e. outside assumpSolve()
+bool
+SatSolver::addClause(vector<unsigned> lits)
+{
+   assert(decisionLevel() == 0);
+   if (!_ok) return false;
+   sort(lits.begin(), lits.end());
+   size_t n = 0;
+   for (size_t i = 0; i < lits.size(); ++i) {
+      unsigned l = lits[i];
+      assert(l / 2 < numVars());
+      // Satisfied, or a tautology (l and ~l are adjacent when sorted)
+      if (litValue(l) == L_TRUE || (n && lits[n - 1] == (l ^ 1)))
+         return true;
+      if (litValue(l) == L_FALSE || (n && lits[n - 1] == l))
+         continue;
+      lits[n++] = l;
+   }
+   lits.resize(n);
+   if (lits.empty())
+      return _ok = false;
+   if (lits.size() == 1) {
+      enqueue(lits[0], NO_REASON);
+      return _ok = (propagate() == NO_REASON);
+   }
+   unsigned c = newClause(lits, false);
+   _clauses.push_back(c);
+   attachClause(c);
+   return true;
+}
+
+void
+SatSolver::addAigCNF(Var vf, Var va, bool fa, Var vb, bool fb)
+{
+   unsigned f = vf * 2, a = va * 2 + fa, b = vb * 2 + fb;
+   vector<unsigned> lits(2);
+   lits[0] = f ^ 1; lits[1] = a;
+   addClause(lits);
+   lits[1] = b;
+   addClause(lits);
+   lits[0] = f; lits[1] = a ^ 1; lits.push_back(b ^ 1);
+   addClause(lits);
+}
+
+void
+SatSolver::addXorCNF(Var vf, Var va, bool fa, Var vb, bool fb)
+{
+   unsigned f = vf * 2, a = va * 2 + fa, b = vb * 2 + fb;
+   vector<unsigned> lits(3);
+   lits[0] = f ^ 1; lits[1] = a;     lits[2] = b;
+   addClause(lits);
+   lits[0] = f ^ 1; lits[1] = a ^ 1; lits[2] = b ^ 1;
+   addClause(lits);
+   lits[0] = f;     lits[1] = a ^ 1; lits[2] = b;
+   addClause(lits);
+   lits[0] = f;     lits[1] = a;     lits[2] = b ^ 1;
+   addClause(lits);
+}
+
+// The model, if SAT, is kept for getValue(); the solver is back at
+// level 0 on return, so clauses can be added for the next call
+SatSolver::Result
+SatSolver::assumpSolve(size_t maxConflicts)
+{
+   _model.clear();
+   if (!_ok) return UNSAT;
+   size_t limit = maxConflicts? _numConflicts + maxConflicts: size_t(-1);
+   _maxLearnts = max(_maxLearnts, _clauses.size() / SAT_LEARNT_RATIO);
+   Result res = UNKNOWN;
+   for (size_t r = 0; res == UNKNOWN && _numConflicts < limit; ++r) {
+      // Learned clauses are deleted between restarts, at level 0, where
+      // no clause is the reason of an assignment that matters
+      if (_learnts.size() >= _maxLearnts) {
+         reduceDB();
+         _maxLearnts *= SAT_LEARNT_GROW;
+      }
+      res = search(luby(r) * SAT_RESTART_BASE, limit);
+   }
+   if (res == SAT)
+      _model.assign(_value.begin(), _value.end());
+   cancelUntil(0);
+   return res;
+}
+
+/***************************************/
+/*   Private functions about clauses   */
+/***************************************/
+float
+SatSolver::clauseAct(unsigned c) const
+{
+   float a;
+   memcpy(&a, &_mem[c + 1], sizeof(a));
+   return a;
+}
+
+void
+SatSolver::setClauseAct(unsigned c, float a)
+{
+   memcpy(&_mem[c + 1], &a, sizeof(a));
+}
+
+unsigned
+SatSolver::newClause(const vector<unsigned>& lits, bool learnt)
+{
+   unsigned c = _mem.size();
+   _mem.push_back((unsigned(lits.size()) << 2) | (learnt? 2: 0));
+   _mem.push_back(0);
+   _mem.insert(_mem.end(), lits.begin(), lits.end());
+   return c;
+}
+
+// Watch the first 2 literals
+void
+SatSolver::attachClause(unsigned c)
+{
+   const unsigned* lits = &_mem[c + 2];
+   _watches[lits[0] ^ 1].push_back(Watcher(c, lits[1]));
+   _watches[lits[1] ^ 1].push_back(Watcher(c, lits[0]));
+}
+
+/******************************************/
+/*   Private functions about assignment   */
+/******************************************/
+void
+SatSolver::enqueue(unsigned l, unsigned reason)
+{
+   Var v = l >> 1;
+   assert(_value[v] == L_UNDEF);
+   _value[v] = (l & 1)? L_FALSE: L_TRUE;
+   _level[v] = decisionLevel();
+   _reason[v] = reason;
+   _trail.push_back(l);
+}
+
+// Return the conflicting clause, or NO_REASON. A clause watches lits[0]
+// and lits[1]; the implied literal of a reason clause is lits[0].
+unsigned
+SatSolver::propagate()
+{
+   unsigned confl = NO_REASON;
+   while (_qhead < _trail.size()) {
+      unsigned p = _trail[_qhead++], falseLit = p ^ 1;
+      vector<Watcher>& ws = _watches[p];
+      size_t i = 0, j = 0, n = ws.size();
+      while (i < n) {
+         Watcher w = ws[i++];
+         if (litValue(w._blocker) == L_TRUE) { ws[j++] = w; continue; }
+         unsigned* lits = clauseLits(w._cref);
+         if (lits[0] == falseLit) swap(lits[0], lits[1]);
+         unsigned first = lits[0];
+         w._blocker = first;
+         if (litValue(first) == L_TRUE) { ws[j++] = w; continue; }
+         // Look for a literal that is not false to watch instead
+         unsigned size = clauseSize(w._cref), k = 2;
+         for (; k < size; ++k)
+            if (litValue(lits[k]) != L_FALSE) break;
+         if (k < size) {
+            lits[1] = lits[k]; lits[k] = falseLit;
+            _watches[lits[1] ^ 1].push_back(w);
+            continue;
+         }
+         ws[j++] = w;
+         if (litValue(first) == L_FALSE) {
+            confl = w._cref;
+            _qhead = _trail.size();
+            while (i < n) ws[j++] = ws[i++];
+         }
+         else enqueue(first, w._cref);
+      }
+      ws.resize(j);
+   }
+   return confl;
+}
+
+// Undo the assignments above 'level', saving their phases
+void
+SatSolver::cancelUntil(unsigned level)
+{
+   if (decisionLevel() <= level) return;
+   for (size_t i = _trail.size(); i > _trailLim[level]; --i) {
+      Var v = _trail[i - 1] >> 1;
+      _polarity[v] = _trail[i - 1] & 1;
+      _value[v] = L_UNDEF;
+      _reason[v] = NO_REASON;
+      if (_heapIdx[v] < 0) heapInsert(v);
+   }
+   _trail.resize(_trailLim[level]);
+   _trailLim.resize(level);
+   _qhead = _trail.size();
+}
+
+/**************************************/
+/*   Private functions about search   */
+/**************************************/
+// Learn the first-UIP clause of conflict 'confl' into 'learnt', the
+// asserting literal first and one of the next highest level second,
+// and set 'btLevel' to that level
+void
+SatSolver::analyze(unsigned confl, vector<unsigned>& learnt,
+                   unsigned& btLevel)
+{
+   learnt.assign(1, NO_LIT);
+   size_t pathC = 0, idx = _trail.size();
+   unsigned p = NO_LIT;
+   do {
+      if (isLearnt(confl)) bumpClause(confl);
+      const unsigned* lits = clauseLits(confl);
+      for (unsigned j = (p == NO_LIT)? 0: 1, n = clauseSize(confl); j < n; ++j) {
+         Var v = lits[j] >> 1;
+         if (_seen[v] || !_level[v]) continue;
+         bumpVar(v);
+         _seen[v] = 1;
+         if (_level[v] >= decisionLevel()) ++pathC;
+         else learnt.push_back(lits[j]);
+      }
+      // The next seen literal of this level on the trail
+      while (!_seen[_trail[--idx] >> 1]);
+      p = _trail[idx];
+      confl = _reason[p >> 1];
+      _seen[p >> 1] = 0;
+   } while (--pathC);
+   learnt[0] = p ^ 1;
+
+   // Drop the literals implied by the others
+   vector<unsigned> all(learnt);
+   size_t n = 1;
+   for (size_t i = 1; i < learnt.size(); ++i)
+      if (!isRedundant(learnt[i])) learnt[n++] = learnt[i];
+   learnt.resize(n);
+   for (size_t i = 1; i < all.size(); ++i)
+      _seen[all[i] >> 1] = 0;
+
+   btLevel = 0;
+   for (size_t i = 1; i < learnt.size(); ++i)
+      if (_level[learnt[i] >> 1] > btLevel) {
+         btLevel = _level[learnt[i] >> 1];
+         swap(learnt[1], learnt[i]);
+      }
+}
+
+// 'l' is implied by literals of the learned clause or of level 0
+bool
+SatSolver::isRedundant(unsigned l) const
+{
+   unsigned c = _reason[l >> 1];
+   if (c == NO_REASON) return false;
+   const unsigned* lits = &_mem[c + 2];
+   for (unsigned j = 1, n = clauseSize(c); j < n; ++j) {
+      Var v = lits[j] >> 1;
+      if (!_seen[v] && _level[v]) return false;
+   }
+   return true;
+}
+
+unsigned
+SatSolver::pickBranchLit()
+{
+   while (!_heap.empty()) {
+      Var v = heapPop();
+      if (_value[v] == L_UNDEF)
+         return v * 2 + _polarity[v];
+   }
+   return NO_LIT;
+}
+
+// Search until a model, a conflict at level 0 or on the assumptions,
+// 'maxConflicts' conflicts (then restart) or 'conflictLimit' conflicts
+// in total
+SatSolver::Result
+SatSolver::search(size_t maxConflicts, size_t conflictLimit)
+{
+   size_t conflicts = 0;
+   vector<unsigned> learnt;
+   for (;;) {
+      unsigned confl = propagate();
+      if (confl != NO_REASON) {
+         ++_numConflicts; ++conflicts;
+         if (decisionLevel() == 0) { _ok = false; return UNSAT; }
+         unsigned btLevel;
+         analyze(confl, learnt, btLevel);
+         cancelUntil(btLevel);
+         if (learnt.size() == 1)
+            enqueue(learnt[0], NO_REASON);
+         else {
+            unsigned c = newClause(learnt, true);
+            _learnts.push_back(c);
+            attachClause(c);
+            bumpClause(c);
+            enqueue(learnt[0], c);
+         }
+         _varInc /= SAT_VAR_DECAY;
+         _clauseInc /= SAT_CLAUSE_DECAY;
+         continue;
+      }
+      if (conflicts >= maxConflicts || _numConflicts >= conflictLimit) {
+         cancelUntil(0);
+         return UNKNOWN;
+      }
+      // Each assumption gets a level of its own, even if already true
+      unsigned next = NO_LIT;
+      while (decisionLevel() < _assumps.size()) {
+         unsigned p = _assumps[decisionLevel()];
+         if (litValue(p) == L_TRUE)
+            _trailLim.push_back(_trail.size());
+         else if (litValue(p) == L_FALSE)
+            return UNSAT;
+         else { next = p; break; }
+      }
+      if (next == NO_LIT) {
+         next = pickBranchLit();
+         if (next == NO_LIT) return SAT;
+         ++_numDecisions;
+      }
+      _trailLim.push_back(_trail.size());
+      enqueue(next, NO_REASON);
+   }
+}
+
+// Delete the less active half of the learned clauses but the binary
+// ones, then compact the clauses and watch them again. At level 0 the
+// reasons are not used any more and are dropped.
+void
+SatSolver::reduceDB()
+{
+   cancelUntil(0);
+   for (size_t i = 0; i < _trail.size(); ++i)
+      _reason[_trail[i] >> 1] = NO_REASON;
+   sort(_learnts.begin(), _learnts.end(), [this](unsigned a, unsigned b) {
+      return clauseAct(a) < clauseAct(b); });
+   for (size_t i = 0; i < _learnts.size() / 2; ++i)
+      if (clauseSize(_learnts[i]) > 2) _mem[_learnts[i]] |= 1;
+
+   vector<unsigned> mem;
+   mem.reserve(_mem.size());
+   vector<unsigned>* lists[2] = { &_clauses, &_learnts };
+   for (size_t k = 0; k < 2; ++k) {
+      vector<unsigned>& list = *lists[k];
+      size_t n = 0;
+      for (size_t i = 0; i < list.size(); ++i) {
+         unsigned c = list[i];
+         if (isDeleted(c)) continue;
+         list[n++] = mem.size();
+         mem.insert(mem.end(), _mem.begin() + c,
+                    _mem.begin() + c + 2 + clauseSize(c));
+      }
+      list.resize(n);
+   }
+   _mem.swap(mem);
+   for (size_t l = 0; l < _watches.size(); ++l)
+      _watches[l].clear();
+   for (size_t i = 0; i < _clauses.size(); ++i)
+      attachClause(_clauses[i]);
+   for (size_t i = 0; i < _learnts.size(); ++i)
+      attachClause(_learnts[i]);
+}
+
+/******************************************/
+/*   Private functions about activities   */
+/******************************************/
+void
+SatSolver::bumpVar(Var v)
+{
+   if ((_activity[v] += _varInc) > 1e100) {
+      for (size_t i = 0; i < _activity.size(); ++i)
+         _activity[i] *= 1e-100;
+      _varInc *= 1e-100;
+   }
+   if (_heapIdx[v] >= 0) heapUp(_heapIdx[v]);
+}
+
+void
+SatSolver::bumpClause(unsigned c)
+{
+   float a = clauseAct(c) + _clauseInc;
+   setClauseAct(c, a);
+   if (a > 1e20) {
+      for (size_t i = 0; i < _learnts.size(); ++i)
+         setClauseAct(_learnts[i], clauseAct(_learnts[i]) * 1e-20);
+      _clauseInc *= 1e-20;
+   }
+}
+
+// _heap is a binary max-heap of the variable activities
+void
+SatSolver::heapInsert(Var v)
+{
+   _heapIdx[v] = _heap.size();
+   _heap.push_back(v);
+   heapUp(_heap.size() - 1);
+}
+
+void
+SatSolver::heapUp(size_t i)
+{
+   Var v = _heap[i];
+   while (i) {
+      size_t parent = (i - 1) / 2;
+      if (!heapLess(v, _heap[parent])) break;
+      _heap[i] = _heap[parent];
+      _heapIdx[_heap[i]] = i;
+      i = parent;
+   }
+   _heap[i] = v;
+   _heapIdx[v] = i;
+}
+
+void
+SatSolver::heapDown(size_t i)
+{
+   Var v = _heap[i];
+   size_t n = _heap.size();
+   for (;;) {
+      size_t c = 2 * i + 1;
+      if (c >= n) break;
+      if (c + 1 < n && heapLess(_heap[c + 1], _heap[c])) ++c;
+      if (!heapLess(_heap[c], v)) break;
+      _heap[i] = _heap[c];
+      _heapIdx[_heap[i]] = i;
+      i = c;
+   }
+   _heap[i] = v;
+   _heapIdx[v] = i;
+}
+
+Var
+SatSolver::heapPop()
+{
+   Var v = _heap[0];
+   _heapIdx[v] = -1;
+   _heap[0] = _heap.back();
+   _heap.pop_back();
+   if (!_heap.empty()) {
+      _heapIdx[_heap[0]] = 0;
+      heapDown(0);
+   }
+   return v;
+}
@@ -0,0 +1,139 @@
+/****************************************************************************
+  FileName     [ cirSat.h ]
+  PackageName  [ cir ]
+  Synopsis     [ Define a CDCL SAT solver for proving AIG equivalences ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2010-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#ifndef CIR_SAT_H
+#define CIR_SAT_H
+
+#include <vector>
+#include <cstddef>
+
+using namespace std;
+
+typedef unsigned Var;
+
+//----------------------------------------------------------------------
+//    SatSolver
+//----------------------------------------------------------------------
+// A conflict-driven clause-learning solver: two watched literals per
+// clause, VSIDS branching with phase saving, first-UIP learning with
+// clause minimization, Luby restarts and activity-based deletion of
+// learned clauses. It is incremental: clauses can be added between
+// calls, and each call solves under the assumptions set by
+// assumeProperty(), which are dropped by assumeRelease().
+//
+// A literal is var * 2 + (1 if negated). The clauses are kept in one
+// array of words: a 2-word header (size and flags, activity) and then
+// the literals.
+//
+class SatSolver
+{
+public:
+   enum Result { UNSAT = 0, SAT = 1, UNKNOWN = 2 };
+
+   SatSolver();
+   ~SatSolver() {}
+
+   Var newVar();
+   size_t numVars() const { return _value.size(); }
+   // Return false if the clauses have become unsatisfiable
+   bool addClause(vector<unsigned> lits);
+   // vf = (va ^ fa) & (vb ^ fb)
+   void addAigCNF(Var vf, Var va, bool fa, Var vb, bool fb);
+   // vf = (va ^ fa) ^ (vb ^ fb)
+   void addXorCNF(Var vf, Var va, bool fa, Var vb, bool fb);
+
+   void assumeRelease() { _assumps.clear(); }
+   void assumeProperty(Var v, bool val) { _assumps.push_back(v * 2 + !val); }
+   // Give up with UNKNOWN after 'maxConflicts' conflicts (0: never)
+   Result assumpSolve(size_t maxConflicts = 0);
+   // The value of 'v' in the last SAT model (0 if it has none)
+   int getValue(Var v) const { return v < _model.size()? _model[v] == 1: 0; }
+
+   size_t numConflicts() const { return _numConflicts; }
+   size_t numDecisions() const { return _numDecisions; }
+   size_t numLearnts() const { return _learnts.size(); }
+
+private:
+   // lbool: 0 false, 1 true, 2 unassigned
+   enum { L_FALSE = 0, L_TRUE = 1, L_UNDEF = 2 };
+   static const unsigned NO_REASON = ~0u;
+   static const unsigned NO_LIT = ~0u;
+
+   struct Watcher
+   {
+      Watcher(unsigned c = 0, unsigned b = 0): _cref(c), _blocker(b) {}
+      unsigned _cref;
+      unsigned _blocker;   // if true, the clause is satisfied
+   };
+
+   // Clause access
+   unsigned  clauseSize(unsigned c) const { return _mem[c] >> 2; }
+   bool      isLearnt(unsigned c) const { return _mem[c] & 2; }
+   bool      isDeleted(unsigned c) const { return _mem[c] & 1; }
+   unsigned* clauseLits(unsigned c) { return &_mem[c + 2]; }
+   float     clauseAct(unsigned c) const;
+   void      setClauseAct(unsigned c, float a);
+   unsigned  newClause(const vector<unsigned>& lits, bool learnt);
+   void      attachClause(unsigned c);
+
+   // Assignment
+   int       litValue(unsigned l) const {
+      char v = _value[l >> 1];
+      return v == L_UNDEF? int(L_UNDEF): v ^ (l & 1);
+   }
+   unsigned  decisionLevel() const { return _trailLim.size(); }
+   void      enqueue(unsigned l, unsigned reason);
+   unsigned  propagate();
+   void      cancelUntil(unsigned level);
+
+   // Search
+   void      analyze(unsigned confl, vector<unsigned>& learnt,
+                     unsigned& btLevel);
+   bool      isRedundant(unsigned l) const;
+   unsigned  pickBranchLit();
+   Result    search(size_t maxConflicts, size_t conflictLimit);
+   void      reduceDB();
+
+   // Activities
+   void      bumpVar(Var v);
+   void      bumpClause(unsigned c);
+   void      heapInsert(Var v);
+   void      heapUp(size_t i);
+   void      heapDown(size_t i);
+   Var       heapPop();
+   bool      heapLess(Var a, Var b) const { return _activity[a] > _activity[b]; }
+
+   bool                    _ok;
+   vector<unsigned>        _mem;
+   vector<unsigned>        _clauses;
+   vector<unsigned>        _learnts;
+   vector<vector<Watcher> > _watches;   // by the literal that falsifies
+
+   vector<char>            _value;
+   vector<char>            _polarity;  // saved phase
+   vector<unsigned>        _level;
+   vector<unsigned>        _reason;
+   vector<unsigned>        _trail;
+   vector<unsigned>        _trailLim;
+   size_t                  _qhead;
+   vector<unsigned>        _assumps;
+   vector<char>            _model;
+
+   vector<double>          _activity;
+   double                  _varInc;
+   double                  _clauseInc;
+   vector<Var>             _heap;
+   vector<int>             _heapIdx;   // -1 if not in _heap
+   mutable vector<char>    _seen;
+   double                  _maxLearnts;
+
+   size_t                  _numConflicts;
+   size_t                  _numDecisions;
+};
+
+#endif // CIR_SAT_H
@@ -0,0 +1,625 @@
+/****************************************************************************
+  FileName     [ cirSim.cpp ]
+  PackageName  [ cir ]
+  Synopsis     [ Define cir simulation functions ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <string>
+#include <chrono>
+#include <cassert>
+#include "cirMgr.h"
+#include "cirGate.h"
+#include "util.h"
+#include "myThread.h"
+#include "myHashSet.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SIM_X86
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+/*******************************/
+/*   Global variable and enum  */
+/*******************************/
+// randomSim() simulates rounds of SIM_RANDOM_BLOCKS pattern blocks (of
+// SIM_WORDS words) until the FEC groups have not split for
+// SIM_RANDOM_STALL rounds, or for at most SIM_RANDOM_ROUNDS rounds
+#define SIM_RANDOM_BLOCKS 8
+#define SIM_RANDOM_STALL  4
+#define SIM_RANDOM_ROUNDS 64
+// #pattern blocks simulated by each kernel in benchSim()
+#define SIM_BENCH_BLOCKS  64
+// #FEC group members refineFecGrps() loads ahead
+#define SIM_PREFETCH      16
+// #pattern blocks read from the file before simulating them
+#define SIM_FILE_BLOCKS   64
+// A level is split over 't' threads only if it has this many AIGs per
+// thread on average; narrower levels spend more time at the barrier
+#define SIM_LEVEL_GRAIN   1024
+
+/**************************************/
+/*   Static variables and functions   */
+/**************************************/
+static inline uint64_t
+randomWord()
+{
+   return (uint64_t(my_random()) << 62) ^ (uint64_t(my_random()) << 31)
+          ^ uint64_t(my_random());
+}
+
+// XOR mask of the slot literal 'lit' (slot * 2 + inverted)
+static inline uint64_t
+litMask(unsigned lit)
+{
+   return uint64_t(0) - (lit & 1);
+}
+
+// Value of word 'w' of the slot literal 'lit'
+static inline uint64_t
+litValue(const uint64_t* v, unsigned lit, size_t w)
+{
+   return v[(lit >> 1) * SIM_WORDS + w] ^ litMask(lit);
+}
+
+static void
+simScalar(const uint64_t* v, const unsigned* f, uint64_t* out, size_t n)
+{
+   for (size_t i = 0; i < n; ++i, f += 2, out += SIM_WORDS) {
+      const uint64_t* a = v + (f[0] >> 1) * SIM_WORDS;
+      const uint64_t* b = v + (f[1] >> 1) * SIM_WORDS;
+      uint64_t ma = litMask(f[0]), mb = litMask(f[1]);
+      for (size_t w = 0; w < SIM_WORDS; ++w)
+         out[w] = (a[w] ^ ma) & (b[w] ^ mb);
+   }
+}
+
+#ifdef SIM_X86
+__attribute__((target("avx2"))) static void
+simAvx2(const uint64_t* v, const unsigned* f, uint64_t* out, size_t n)
+{
+   for (size_t i = 0; i < n; ++i, f += 2, out += SIM_WORDS) {
+      const uint64_t* a = v + (f[0] >> 1) * SIM_WORDS;
+      const uint64_t* b = v + (f[1] >> 1) * SIM_WORDS;
+      __m256i ma = _mm256_set1_epi64x(-(long long)(f[0] & 1));
+      __m256i mb = _mm256_set1_epi64x(-(long long)(f[1] & 1));
+      for (size_t w = 0; w < SIM_WORDS; w += 4) {
+         __m256i x = _mm256_loadu_si256((const __m256i*)(a + w));
+         __m256i y = _mm256_loadu_si256((const __m256i*)(b + w));
+         _mm256_storeu_si256((__m256i*)(out + w),
+            _mm256_and_si256(_mm256_xor_si256(x, ma),
+                             _mm256_xor_si256(y, mb)));
+      }
+   }
+}
+
+__attribute__((target("avx512f"))) static void
+simAvx512(const uint64_t* v, const unsigned* f, uint64_t* out, size_t n)
+{
+   for (size_t i = 0; i < n; ++i, f += 2, out += SIM_WORDS) {
+      const uint64_t* a = v + (f[0] >> 1) * SIM_WORDS;
+      const uint64_t* b = v + (f[1] >> 1) * SIM_WORDS;
+      __m512i ma = _mm512_set1_epi64(-(long long)(f[0] & 1));
+      __m512i mb = _mm512_set1_epi64(-(long long)(f[1] & 1));
+      __m512i x = _mm512_loadu_si512(a);
+      __m512i y = _mm512_loadu_si512(b);
+      _mm512_storeu_si512(out, _mm512_and_si512(_mm512_xor_si512(x, ma),
+                                                _mm512_xor_si512(y, mb)));
+   }
+}
+#endif
+
+struct SimKernelInfo
+{
+   const char*    _name;
+   SimKernel      _kernel;
+   bool           _ok;     // supported by this CPU
+};
+
+// Fastest first
+static SimKernelInfo*
+simKernels(size_t& n)
+{
+   static SimKernelInfo kernels[] = {
+#ifdef SIM_X86
+      { "AVX-512", simAvx512, bool(__builtin_cpu_supports("avx512f")) },
+      { "AVX2", simAvx2, bool(__builtin_cpu_supports("avx2")) },
+#endif
+      { "Scalar", simScalar, true }
+   };
+   n = sizeof(kernels) / sizeof(kernels[0]);
+   return kernels;
+}
+
+// The fastest kernel supported by this CPU; picked once
+static SimKernel
+bestSimKernel()
+{
+   static SimKernel kernel = 0;
+   if (!kernel) {
+      size_t n;
+      SimKernelInfo* kernels = simKernels(n);
+      for (size_t i = 0; !kernel; ++i)
+         if (kernels[i]._ok) kernel = kernels[i]._kernel;
+   }
+   return kernel;
+}
+
+// Key of a FEC group member in CirMgr::refineFecGrps(): its words in a
+// block, complemented if its phase is 1, and the group it was in; the
+// members with equal keys go to the new group _newGrp
+class FecKey
+{
+public:
+   FecKey(const uint64_t* v = 0, unsigned lit = 0, unsigned grp = 0)
+      : _v(v), _mask(litMask(lit)), _grp(grp), _newGrp(0) {}
+
+   size_t operator () () const {
+      size_t k = _grp;
+      for (size_t w = 0; w < SIM_WORDS; ++w)
+         k = (k ^ _v[w] ^ _mask) * 0x100000001b3ULL;
+      return k ^ (k >> 32);
+   }
+   bool operator == (const FecKey& k) const {
+      if (_grp != k._grp) return false;
+      for (size_t w = 0; w < SIM_WORDS; ++w)
+         if ((_v[w] ^ _mask) != (k._v[w] ^ k._mask)) return false;
+      return true;
+   }
+
+   unsigned getNewGrp() const { return _newGrp; }
+   void setNewGrp(unsigned g) { _newGrp = g; }
+
+private:
+   const uint64_t*   _v;
+   uint64_t          _mask;
+   unsigned          _grp;
+   unsigned          _newGrp;
+};
+
+/************************************************/
+/*   Public member functions about Simulation   */
+/************************************************/
+// The patterns are drawn before simulating, so that they do not depend
+// on the number of threads
+void
+CirMgr::randomSim()
+{
+   buildSimProg();
+   size_t numPIWords = _PIs.size() * SIM_WORDS;
+   size_t numRounds = 0, numStall = 0;
+   vector<uint64_t> piValue(numPIWords * SIM_RANDOM_BLOCKS);
+   while (numStall < SIM_RANDOM_STALL && numRounds < SIM_RANDOM_ROUNDS) {
+      size_t numGrps = _fecGrps.size(), numFecs = numFecGates();
+      bool init = _fecInit;
+      for (size_t i = 0; i < piValue.size(); ++i)
+         piValue[i] = randomWord();
+      simBlocks(piValue, SIM_RANDOM_BLOCKS, SIM_PATTERNS,
+                pickSimPartition(SIM_RANDOM_BLOCKS, _numThreads),
+                _numThreads);
+      ++numRounds;
+      if (init && _fecGrps.size() == numGrps && numFecGates() == numFecs)
+         ++numStall;
+      else
+         numStall = 0;
+   }
+   cout << "Total #FEC Group = " << _fecGrps.size() << endl;
+   cout << numRounds * SIM_RANDOM_BLOCKS * SIM_PATTERNS
+        << " patterns simulated." << endl;
+}
+
+// Each pattern is a string of '0'/'1', one for each PI in order;
+// patterns are separated by white spaces. At an illegal pattern the
+// error is reported and the patterns before it are simulated.
+// The patterns are simulated SIM_FILE_BLOCKS blocks at a time.
+void
+CirMgr::fileSim(ifstream& patternFile)
+{
+   buildSimProg();
+   size_t numPIs = _PIs.size(), numPIWords = numPIs * SIM_WORDS;
+   size_t cnt = 0, k = 0;   // k: #patterns read into piValue
+   vector<uint64_t> piValue(numPIWords * SIM_FILE_BLOCKS, 0);
+   string str;
+   while (patternFile >> str) {
+      if (str.size() != numPIs) {
+         cerr << "Error: Pattern(" << str << ") length(" << str.size()
+              << ") does not match the number of inputs(" << numPIs
+              << ") in a circuit!!" << endl;
+         break;
+      }
+      size_t i = str.find_first_not_of("01");
+      if (i != string::npos) {
+         cerr << "Error: Pattern(" << str << ") contains a non-0/1 character('"
+              << str[i] << "')." << endl;
+         break;
+      }
+      uint64_t* pi = &piValue[k / SIM_PATTERNS * numPIWords];
+      size_t b = k % SIM_PATTERNS;
+      for (i = 0; i < numPIs; ++i)
+         pi[i * SIM_WORDS + b / 64] |= uint64_t(str[i] - '0') << (b % 64);
+      ++cnt;
+      if (++k == SIM_PATTERNS * SIM_FILE_BLOCKS) {
+         simBlocks(piValue, SIM_FILE_BLOCKS, SIM_PATTERNS,
+                   pickSimPartition(SIM_FILE_BLOCKS, _numThreads),
+                   _numThreads);
+         fill(piValue.begin(), piValue.end(), uint64_t(0));
+         k = 0;
+      }
+   }
+   if (k) {
+      size_t numBlocks = (k + SIM_PATTERNS - 1) / SIM_PATTERNS;
+      simBlocks(piValue, numBlocks, (k - 1) % SIM_PATTERNS + 1,
+                pickSimPartition(numBlocks, _numThreads), _numThreads);
+   }
+   cout << "Total #FEC Group = " << _fecGrps.size() << endl;
+   cout << cnt << " patterns simulated." << endl;
+}
+
+// Time each kernel supported by this CPU on the same random blocks, and
+// then the two ways to split them over 1, 2, 4, 8 and 16 threads; check
+// that they all give the PO values of the scalar kernel
+void
+CirMgr::benchSim()
+{
+   buildSimProg();
+   size_t numKernels, numAIGs = _simFanin.size() / 2;
+   size_t numPIWords = _PIs.size() * SIM_WORDS;
+   size_t numPOWords = _POs.size() * SIM_WORDS;
+   SimKernelInfo* kernels = simKernels(numKernels);
+   vector<uint64_t> piValue(numPIWords * SIM_BENCH_BLOCKS);
+   for (size_t i = 0; i < piValue.size(); ++i)
+      piValue[i] = randomWord();
+   vector<uint64_t> golden, poValue(numPOWords * SIM_BENCH_BLOCKS);
+   double scalarTime = 0;
+
+   cout << "Simulating " << SIM_BENCH_BLOCKS * SIM_PATTERNS
+        << " patterns on " << numAIGs << " AIGs in "
+        << _simLevel.size() - 1 << " levels" << endl
+        << setw(10) << left << "Kernel" << right << setw(12) << "ns/AIG"
+        << setw(16) << "Gevals/sec" << setw(10) << "Speedup" << endl;
+   for (size_t j = numKernels; j-- > 0; ) {
+      if (!kernels[j]._ok) continue;
+      chrono::duration<double> d(0);
+      for (size_t k = 0; k < SIM_BENCH_BLOCKS; ++k) {
+         copy(piValue.begin() + k * numPIWords,
+              piValue.begin() + (k + 1) * numPIWords,
+              _simValue.begin() + SIM_WORDS);
+         chrono::steady_clock::time_point start = chrono::steady_clock::now();
+         simulate(&_simValue[0], kernels[j]._kernel);
+         d += chrono::steady_clock::now() - start;
+         getSimPo(&_simValue[0], &poValue[k * numPOWords]);
+      }
+      if (!scalarTime) {
+         scalarTime = d.count();
+         golden = poValue;
+      }
+      double nsPerAIG = numAIGs? d.count() * 1e9 / numAIGs
+                                 / SIM_BENCH_BLOCKS: 0;
+      cout << setw(10) << left << kernels[j]._name << right << fixed
+           << setw(12) << setprecision(3) << nsPerAIG
+           << setw(16) << setprecision(2)
+           << (nsPerAIG? SIM_PATTERNS / nsPerAIG: 0)
+           << setw(10) << setprecision(2) << (d.count()?
+                                              scalarTime / d.count(): 0)
+           << (poValue != golden? "  MISMATCH": "") << endl;
+      cout.unsetf(ios::fixed);
+   }
+
+   static const char* partitionStr[] = { "Blocks", "Levels" };
+   cout << endl << setw(10) << left << "Threads" << right;
+   for (size_t p = 0; p < 2; ++p)
+      cout << setw(12) << partitionStr[p] << setw(10) << "Speedup";
+   cout << setw(10) << "Picked" << endl;
+   ofstream* simLog = _simLog;
+   _simLog = 0;
+   double serialTime = 0;
+   for (unsigned t = 1; t <= 16; t *= 2) {
+      cout << setw(10) << left << t << right << fixed;
+      bool mismatch = false;
+      for (size_t p = 0; p < 2; ++p) {
+         // Narrow levels would keep the threads at the barrier for long
+         if (p == SIM_LEVELS && t > 1 && !wideSimLevels(t)) {
+            cout << setw(12) << "-" << setw(10) << "-";
+            continue;
+         }
+         chrono::steady_clock::time_point start = chrono::steady_clock::now();
+         simBlocks(piValue, SIM_BENCH_BLOCKS, SIM_PATTERNS, SimPartition(p),
+                   t, &poValue, false);
+         chrono::duration<double> d = chrono::steady_clock::now() - start;
+         if (!serialTime) serialTime = d.count();
+         mismatch |= (poValue != golden);
+         cout << setw(11) << setprecision(3) << d.count() << "s"
+              << setw(10) << setprecision(2)
+              << (d.count()? serialTime / d.count(): 0);
+      }
+      cout << setw(10) << partitionStr[pickSimPartition(SIM_BENCH_BLOCKS, t)]
+           << (mismatch? "  MISMATCH": "") << endl;
+      cout.unsetf(ios::fixed);
+   }
+   _simLog = simLog;
+}
+
+/*************************************************/
+/*   Private member functions about Simulation   */
+/*************************************************/
+// Number the gates in slots: 0 for CONST0 (and floating fanins, which
+// are simulated as 0), 1..I for the PIs, then the AIGs of getDfsList()
+// by level (1 + the max level of the fanins; the PIs are at level 0),
+// in DFS order within a level. The AIGs of level l are then
+// [_simLevel[l - 1], _simLevel[l]) and can be evaluated in parallel.
+void
+CirMgr::buildSimProg()
+{
+   if (!_simIds.empty()) return;
+   const GateList& dfsList = getDfsList();
+   IdList level(_maxId, 0), slotOf(_maxId, 0);
+   _simLevel.assign(1, 0);
+   for (size_t n = 0; n < dfsList.size(); ++n) {
+      const CirGate* g = dfsList[n];
+      if (g->getType() != AIG_GATE) continue;
+      unsigned l = max(level[g->getFaninId(0) / 2],
+                       level[g->getFaninId(1) / 2]) + 1;
+      level[g->getId()] = l;
+      if (l >= _simLevel.size()) _simLevel.resize(l + 1, 0);
+      ++_simLevel[l];
+   }
+   // _simLevel[l]: #AIGs up to level l, counted from the first AIG slot
+   for (size_t l = 1; l < _simLevel.size(); ++l)
+      _simLevel[l] += _simLevel[l - 1];
+   IdList next(_simLevel.begin(), _simLevel.end() - 1);
+
+   size_t numPIs = _PIs.size();
+   _simIds.assign(1 + numPIs + _simLevel.back(), 0);
+   for (size_t i = 0; i < numPIs; ++i) {
+      slotOf[_PIs[i]->getId()] = 1 + i;
+      _simIds[1 + i] = _PIs[i]->getId();
+   }
+   for (size_t n = 0; n < dfsList.size(); ++n) {
+      const CirGate* g = dfsList[n];
+      if (g->getType() != AIG_GATE) continue;
+      unsigned slot = 1 + numPIs + next[level[g->getId()] - 1]++;
+      slotOf[g->getId()] = slot;
+      _simIds[slot] = g->getId();
+   }
+   _simFanin.resize(2 * _simLevel.back());
+   for (size_t j = 0; j < _simLevel.back(); ++j) {
+      const CirGate* g = getGate(_simIds[1 + numPIs + j]);
+      for (size_t i = 0; i < 2; ++i) {
+         unsigned lit = g->getFaninId(i);
+         _simFanin[2 * j + i] = slotOf[lit / 2] * 2 + lit % 2;
+      }
+   }
+   _simPo.resize(_POs.size());
+   for (size_t i = 0; i < _POs.size(); ++i) {
+      unsigned lit = _POs[i]->getFaninId(0);
+      _simPo[i] = slotOf[lit / 2] * 2 + lit % 2;
+   }
+   _simValue.assign(_simIds.size() * SIM_WORDS, 0);
+}
+
+// Split the blocks over the threads if there are enough of them, as the
+// threads then never wait for each other; otherwise split each level if
+// the levels are wide enough
+SimPartition
+CirMgr::pickSimPartition(size_t numBlocks, unsigned t) const
+{
+   if (t <= 1 || numBlocks >= t || !wideSimLevels(t))
+      return SIM_BLOCKS;
+   return SIM_LEVELS;
+}
+
+bool
+CirMgr::wideSimLevels(unsigned t) const
+{
+   size_t numLevels = _simLevel.size() - 1;
+   return numLevels && _simLevel.back() / numLevels >= SIM_LEVEL_GRAIN * t;
+}
+
+// Simulate 'numBlocks' blocks of PI values, numPIs * SIM_WORDS words
+// each, in 'piValue' on 't' threads; all the patterns but the last
+// 'lastK' ones of the last block are valid. Log the patterns in order,
+// keep the PO values of each block in 'poValue' if given, and refine the
+// FEC groups if 'refine'. With SIM_BLOCKS, the blocks go in waves of 't',
+// one for each thread with its own copy of the values; with SIM_LEVELS,
+// they go one by one with each level split over the threads.
+void
+CirMgr::simBlocks(const vector<uint64_t>& piValue, size_t numBlocks,
+                  size_t lastK, SimPartition partition, unsigned t,
+                  vector<uint64_t>* poValue, bool refine)
+{
+   size_t numPIWords = _PIs.size() * SIM_WORDS;
+   size_t numPOWords = _POs.size() * SIM_WORDS;
+   vector<uint64_t> localPo;
+   if (!poValue) poValue = &localPo;
+   poValue->resize(numPOWords * numBlocks);
+   SimKernel kernel = bestSimKernel();
+   size_t waveSize = (partition == SIM_BLOCKS)? min<size_t>(t, numBlocks): 1;
+   vector<vector<uint64_t> > local(waveSize? waveSize - 1: 0,
+                                   vector<uint64_t>(_simValue.size(), 0));
+   vector<uint64_t*> values(1, &_simValue[0]);
+   for (size_t k = 0; k < local.size(); ++k)
+      values.push_back(&local[k][0]);
+   for (size_t j = 0; j < numBlocks; j += waveSize) {
+      size_t n = min(waveSize, numBlocks - j);
+      for (size_t k = 0; k < n; ++k)
+         copy(piValue.begin() + (j + k) * numPIWords,
+              piValue.begin() + (j + k + 1) * numPIWords,
+              values[k] + SIM_WORDS);
+      if (partition == SIM_BLOCKS)
+         parallelRanges(n, n, [&](unsigned, size_t b, size_t e) {
+            for (size_t k = b; k < e; ++k)
+               simulate(values[k], kernel);
+         });
+      else {
+         uint64_t* v = values[0];
+         const unsigned* f = _simFanin.empty()? 0: &_simFanin[0];
+         uint64_t* out = v + (1 + _PIs.size()) * SIM_WORDS;
+         parallelSteps(_simLevel.size() - 1, t, [&](unsigned k, size_t l) {
+            size_t b = _simLevel[l], m = _simLevel[l + 1] - b;
+            size_t e = b + m * (k + 1) / t;
+            b += m * k / t;
+            kernel(v, f + 2 * b, out + b * SIM_WORDS, e - b);
+         });
+      }
+      for (size_t k = 0; k < n; ++k)
+         getSimPo(values[k], &(*poValue)[(j + k) * numPOWords]);
+      if (refine)
+         refineFecGrps(&values[0], n);
+   }
+   for (size_t j = 0; j < numBlocks; ++j)
+      writeSimLog(&piValue[j * numPIWords], &(*poValue)[j * numPOWords],
+                  j + 1 < numBlocks? SIM_PATTERNS: lastK);
+}
+
+// Split the FEC groups by the values of each of the 'n' blocks. The
+// first block ever simulated makes CONST0 and all the AIGs one group,
+// and fixes the phase of each member to its value on the first pattern,
+// so that a gate and an inverted one get the same key. The members of a
+// group that splits are hashed by their group and block words, so a
+// round is linear in the number of members.
+void
+CirMgr::refineFecGrps(uint64_t* const* values, size_t n)
+{
+   if (!_fecInit) {
+      _fecInit = true;
+      IdList grp(1, 0);
+      for (size_t s = 1 + _PIs.size(); s < _simIds.size(); ++s)
+         grp.push_back(s * 2 + (values[0][s * SIM_WORDS] & 1));
+      if (grp.size() > 1) _fecGrps.push_back(grp);
+   }
+   size_t numFecs = numFecGates();
+   if (!numFecs) return;
+   HashSet<FecKey> hash(getHashSize(numFecs));
+   vector<IdList> grps;
+   for (size_t k = 0; k < n; ++k) {
+      const uint64_t* v = values[k];
+      bool hashed = false;
+      grps.clear();
+      for (size_t g = 0; g < _fecGrps.size(); ++g) {
+         IdList& grp = _fecGrps[g];
+         // Most groups do not split; keep them without hashing
+         FecKey first(v + (grp[0] >> 1) * SIM_WORDS, grp[0], g);
+         size_t i = 1, m = grp.size();
+         for (; i < m; ++i) {
+            // The members are scattered over the values; load ahead
+            if (i + SIM_PREFETCH < m)
+               __builtin_prefetch(v + (grp[i + SIM_PREFETCH] >> 1) * SIM_WORDS);
+            if (!(FecKey(v + (grp[i] >> 1) * SIM_WORDS, grp[i], g) == first))
+               break;
+         }
+         if (i == m) {
+            grps.push_back(IdList());
+            grps.back().swap(grp);
+            continue;
+         }
+         // Only the members that differ from the first one are hashed
+         size_t firstGrp = grps.size();
+         grps.push_back(IdList(grp.begin(), grp.begin() + i));
+         if (!hashed) { hash.clear(); hashed = true; }
+         for (; i < m; ++i) {
+            FecKey key(v + (grp[i] >> 1) * SIM_WORDS, grp[i], g);
+            if (key == first)
+               grps[firstGrp].push_back(grp[i]);
+            else if (hash.query(key))
+               grps[key.getNewGrp()].push_back(grp[i]);
+            else {
+               key.setNewGrp(grps.size());
+               grps.push_back(IdList(1, grp[i]));
+               hash.insert(key);
+            }
+         }
+      }
+      _fecGrps.clear();
+      for (size_t g = 0; g < grps.size(); ++g)
+         if (grps[g].size() > 1) {
+            _fecGrps.push_back(IdList());
+            _fecGrps.back().swap(grps[g]);
+         }
+   }
+}
+
+size_t
+CirMgr::numFecGates() const
+{
+   size_t n = 0;
+   for (size_t g = 0; g < _fecGrps.size(); ++g)
+      n += _fecGrps[g].size();
+   return n;
+}
+
+// Evaluate all the AIGs on the PI blocks in v[SIM_WORDS..]
+void
+CirMgr::simulate(uint64_t* v, SimKernel kernel) const
+{
+   if (_simFanin.empty()) return;
+   kernel(v, &_simFanin[0], v + (1 + _PIs.size()) * SIM_WORDS,
+          _simFanin.size() / 2);
+}
+
+// The PO blocks, with the inversions of the PO fanins applied
+void
+CirMgr::getSimPo(const uint64_t* v, uint64_t* po) const
+{
+   for (size_t i = 0; i < _simPo.size(); ++i)
+      for (size_t w = 0; w < SIM_WORDS; ++w)
+         po[i * SIM_WORDS + w] = litValue(v, _simPo[i], w);
+}
+
+// One line for each of the first 'k' patterns of a block: the PI values,
+// a space, and the PO values
+void
+CirMgr::writeSimLog(const uint64_t* pi, const uint64_t* po, size_t k) const
+{
+   if (!_simLog) return;
+   size_t numPIs = _PIs.size(), numPOs = _POs.size();
+   string line(numPIs + numPOs + 2, '\n');
+   line[numPIs] = ' ';
+   for (size_t b = 0; b < k; ++b) {
+      size_t w = b / 64, s = b % 64;
+      for (size_t i = 0; i < numPIs; ++i)
+         line[i] = '0' + ((pi[i * SIM_WORDS + w] >> s) & 1);
+      for (size_t i = 0; i < numPOs; ++i)
+         line[numPIs + 1 + i] = '0' + ((po[i * SIM_WORDS + w] >> s) & 1);
+      _simLog->write(line.data(), line.size());
+   }
+}
+
+// Simulate up to 'numRounds' rounds of random blocks as randomSim()
+// does, stopping after a round in which a PO is 1; cex[i] is then the
+// first pattern (a '0'/'1' for each PI) on which PO i is 1, or empty
+void
+CirMgr::randomSimPo(size_t numRounds, vector<string>& cex)
+{
+   buildSimProg();
+   size_t numPIs = _PIs.size(), numPOs = _POs.size();
+   size_t numPIWords = numPIs * SIM_WORDS, numPOWords = numPOs * SIM_WORDS;
+   vector<uint64_t> piValue(numPIWords * SIM_RANDOM_BLOCKS), poValue;
+   cex.assign(numPOs, string());
+   bool found = false;
+   for (size_t r = 0; r < numRounds && !found; ++r) {
+      for (size_t i = 0; i < piValue.size(); ++i)
+         piValue[i] = randomWord();
+      simBlocks(piValue, SIM_RANDOM_BLOCKS, SIM_PATTERNS,
+                pickSimPartition(SIM_RANDOM_BLOCKS, _numThreads),
+                _numThreads, &poValue);
+      for (size_t j = 0; j < SIM_RANDOM_BLOCKS; ++j)
+         for (size_t i = 0; i < numPOs; ++i) {
+            const uint64_t* po = &poValue[j * numPOWords + i * SIM_WORDS];
+            size_t w = 0;
+            while (w < SIM_WORDS && !po[w]) ++w;
+            if (w == SIM_WORDS || !cex[i].empty()) continue;
+            size_t s = __builtin_ctzll(po[w]);
+            const uint64_t* pi = &piValue[j * numPIWords];
+            cex[i].resize(numPIs);
+            for (size_t p = 0; p < numPIs; ++p)
+               cex[i][p] = '0' + ((pi[p * SIM_WORDS + w] >> s) & 1);
+            found = true;
+         }
+   }
+}
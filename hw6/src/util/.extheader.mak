@@ -1,4 +1,4 @@
-util.d: ../../include/util.h ../../include/rnGen.h ../../include/myUsage.h 
+util.d: ../../include/util.h ../../include/rnGen.h ../../include/myUsage.h ../../include/myPool.h ../../include/myThread.h ../../include/myHashSet.h 
 ../../include/util.h: util.h
 	@rm -f ../../include/util.h
 	@ln -fs ../src/util/util.h ../../include/util.h
@@ -8,3 +8,12 @@ util.d: ../../include/util.h ../../include/rnGen.h ../../include/myUsage.h
 ../../include/myUsage.h: myUsage.h
 	@rm -f ../../include/myUsage.h
 	@ln -fs ../src/util/myUsage.h ../../include/myUsage.h
+../../include/myPool.h: myPool.h
+	@rm -f ../../include/myPool.h
+	@ln -fs ../src/util/myPool.h ../../include/myPool.h
+../../include/myThread.h: myThread.h
+	@rm -f ../../include/myThread.h
+	@ln -fs ../src/util/myThread.h ../../include/myThread.h
+../../include/myHashSet.h: myHashSet.h
+	@rm -f ../../include/myHashSet.h
+	@ln -fs ../src/util/myHashSet.h ../../include/myHashSet.h
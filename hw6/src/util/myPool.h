@@ -0,0 +1,196 @@
+/****************************************************************************
+  FileName     [ myPool.h ]
+  PackageName  [ util ]
+  Synopsis     [ Define memory arena and typed object pool ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2007-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#ifndef MY_POOL_H
+#define MY_POOL_H
+
+#include <cassert>
+#include <cstdlib>
+#include <new>
+#include <utility>
+#ifdef __linux__
+#include <sys/mman.h>
+#endif // __linux__
+
+using namespace std;
+
+// Default #Bytes of a chunk of MyArena
+#define MY_ARENA_CHUNK 1048576
+
+//----------------------------------------------------------------------
+//    MyArena
+//----------------------------------------------------------------------
+// Memory is carved from big malloc'ed chunks and can only be freed all
+// at once, by reset() or the destructor. Each new chunk is as big as
+// all the previous ones (at least the given chunk size), so there are
+// O(log(size)) chunks to free. Requests larger than 1/4 of a chunk get
+// a chunk of their own.
+// Note: destructors of the objects created in it are NOT called by
+// reset(); use it for objects whose members do not own heap memory,
+// or call the destructors before reset().
+//
+class MyArena
+{
+   // Header of each chunk
+   struct Chunk {
+      Chunk*   _next;
+      size_t   _size;   // #Bytes after the header
+   };
+
+public:
+   MyArena(size_t c = MY_ARENA_CHUNK)
+   : _chunkSize(c), _chunks(0), _ptr(0), _end(0), _numChunks(0),
+     _allocSize(0) {}
+   ~MyArena() { release(); }
+
+   // 't' Bytes aligned to 'a' (a power of 2); throw bad_alloc() if failed
+   void* alloc(size_t t, size_t a = sizeof(size_t)) {
+      assert((a & (a - 1)) == 0);
+      char* p = (char*)((size_t(_ptr) + a - 1) & ~(a - 1));
+      if (!_ptr || p + t > _end) {
+         size_t c = (_allocSize > _chunkSize)? _allocSize: _chunkSize;
+         if (t + a > c / 4) return allocLarge(t, a);
+         newChunk(c);
+         p = (char*)((size_t(_ptr) + a - 1) & ~(a - 1));
+      }
+      _ptr = p + t;
+      return p;
+   }
+   template <class T> T* allocArr(size_t n) {
+      return (T*)alloc(n * sizeof(T), alignof(T)); }
+   // Construct a T in the arena
+   template <class T, class... Args> T* create(Args&&... args) {
+      return new (alloc(sizeof(T), alignof(T))) T(forward<Args>(args)...); }
+
+   // Free all but the current chunk
+   void reset() {
+      Chunk* keep = 0;
+      if (_ptr) { keep = _chunks; _chunks = _chunks->_next; }
+      release();
+      if (keep) {
+         keep->_next = 0; _chunks = keep; _numChunks = 1;
+         _allocSize = sizeof(Chunk) + keep->_size;
+         _ptr = (char*)(keep + 1); _end = _ptr + keep->_size;
+      }
+   }
+   // Free all the chunks
+   void release() {
+      while (_chunks) {
+         Chunk* c = _chunks; _chunks = c->_next;
+         ::free(c);
+      }
+      _ptr = _end = 0; _numChunks = 0; _allocSize = 0;
+   }
+
+   size_t getNumChunks() const { return _numChunks; }
+   // #Bytes malloc'ed
+   size_t getAllocSize() const { return _allocSize; }
+
+private:
+   size_t      _chunkSize;
+   Chunk*      _chunks;      // the current chunk (if _ptr) comes first
+   char*       _ptr;         // free memory of the current chunk
+   char*       _end;
+   size_t      _numChunks;
+   size_t      _allocSize;
+
+   Chunk* mallocChunk(size_t s) {
+      Chunk* c = (Chunk*)malloc(sizeof(Chunk) + s);
+      if (!c) throw bad_alloc();
+      c->_size = s;
+      adviseHugePages(c + 1, s);
+      ++_numChunks; _allocSize += sizeof(Chunk) + s;
+      return c;
+   }
+   // Chunks of many huge pages are mostly touched at random by big
+   // circuits; ask for transparent huge pages to cut the page faults
+   // and TLB misses
+   static void adviseHugePages(void* p, size_t s) {
+      #ifdef MADV_HUGEPAGE
+      const size_t h = size_t(1) << 21;
+      size_t b = (size_t(p) + h - 1) & ~(h - 1), e = (size_t(p) + s) & ~(h - 1);
+      if (e >= b + 4 * h) madvise((void*)b, e - b, MADV_HUGEPAGE);
+      #endif // MADV_HUGEPAGE
+   }
+   void newChunk(size_t s) {
+      Chunk* c = mallocChunk(s);
+      c->_next = _chunks; _chunks = c;
+      _ptr = (char*)(c + 1); _end = _ptr + s;
+   }
+   // Own chunk, linked after the current one
+   void* allocLarge(size_t t, size_t a) {
+      Chunk* c = mallocChunk(t + a);
+      if (_chunks) { c->_next = _chunks->_next; _chunks->_next = c; }
+      else { c->_next = 0; _chunks = c; }
+      return (void*)((size_t(c + 1) + a - 1) & ~(a - 1));
+   }
+};
+
+//----------------------------------------------------------------------
+//    MyPool<T>
+//----------------------------------------------------------------------
+// Objects of T (or of a class derived from T of no bigger size) are
+// created in a MyArena and recycled through a free list by destroy().
+// clear() drops all of them at once without calling their destructors.
+// The arena is the pool's own, or one shared with other data of the
+// same lifetime (which is then reset by its owner, not by clear()).
+//
+template <class T>
+class MyPool
+{
+public:
+   MyPool(size_t c = MY_ARENA_CHUNK)
+   : _ownArena(c), _arena(&_ownArena), _free(0), _numObjs(0) {}
+   MyPool(MyArena& a) : _arena(&a), _free(0), _numObjs(0) {}
+   ~MyPool() {}
+
+   template <class U = T, class... Args> U* create(Args&&... args) {
+      static_assert(sizeof(U) <= _objSize && alignof(U) <= alignof(T),
+                    "MyPool<T>: U does not fit in T");
+      void* p;
+      if (_free) { p = _free; _free = *(void**)p; }
+      else p = _arena->alloc(_objSize, alignof(T));
+      ++_numObjs;
+      return new (p) U(forward<Args>(args)...);
+   }
+   // Memory for 'n' consecutive objects of U, which are constructed by
+   // the caller (e.g. on several threads); each of them can be destroyed
+   template <class U = T> U* allocArr(size_t n) {
+      static_assert(sizeof(U) == _objSize && alignof(U) <= alignof(T),
+                    "MyPool<T>: U is not of the size of T");
+      _numObjs += n;
+      return (U*)_arena->alloc(n * _objSize, alignof(T));
+   }
+   // Call the (virtual) destructor of 'p' and recycle its memory
+   void destroy(T* p) {
+      assert(_numObjs > 0);
+      p->~T();
+      *(void**)p = _free; _free = p;
+      --_numObjs;
+   }
+   void clear() {
+      if (_arena == &_ownArena) _arena->reset();
+      _free = 0; _numObjs = 0;
+   }
+
+   // #objects created but not destroyed
+   size_t size() const { return _numObjs; }
+   const MyArena& getArena() const { return *_arena; }
+
+private:
+   // A recycled object holds the free-list link
+   static const size_t _objSize =
+      (sizeof(T) < sizeof(void*))? sizeof(void*): sizeof(T);
+
+   MyArena     _ownArena;
+   MyArena*    _arena;
+   void*       _free;
+   size_t      _numObjs;
+};
+
+#endif // MY_POOL_H
@@ -0,0 +1,65 @@
+/****************************************************************************
+  FileName     [ myThread.h ]
+  PackageName  [ util ]
+  Synopsis     [ Run loops over index ranges on several threads ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2007-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#ifndef MY_THREAD_H
+#define MY_THREAD_H
+
+#include <cstddef>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Split [0, n) into 't' contiguous ranges (the k-th one is
+// [n * k / t, n * (k + 1) / t)) and call f(k, begin, end) for each of
+// them, range 0 on the calling thread. Return when all are done.
+// With t <= 1 it is a plain call of f(0, 0, n).
+template <class F>
+void parallelRanges(size_t n, unsigned t, F f)
+{
+   if (t <= 1) { f(0, size_t(0), n); return; }
+   vector<thread> workers;
+   workers.reserve(t - 1);
+   for (unsigned k = 1; k < t; ++k)
+      workers.push_back(thread(f, k, n * k / t, n * (k + 1) / t));
+   f(0, size_t(0), n / t);
+   for (size_t k = 0; k < workers.size(); ++k)
+      workers[k].join();
+}
+
+// Call f(k, s) for s = 0, 1, ..., numSteps - 1 on each of 't' threads,
+// thread 0 being the calling one; no thread starts step s + 1 before
+// all of them have finished step s. The threads are started once, and
+// wait at the barrier by yielding. With t <= 1 it is a plain loop.
+template <class F>
+void parallelSteps(size_t numSteps, unsigned t, F f)
+{
+   if (t <= 1) {
+      for (size_t s = 0; s < numSteps; ++s) f(0u, s);
+      return;
+   }
+   atomic<size_t> done(0);   // #steps finished, summed over the threads
+   auto run = [&](unsigned k) {
+      for (size_t s = 0; s < numSteps; ++s) {
+         f(k, s);
+         ++done;
+         while (done.load() < (s + 1) * t)
+            this_thread::yield();
+      }
+   };
+   vector<thread> workers;
+   workers.reserve(t - 1);
+   for (unsigned k = 1; k < t; ++k)
+      workers.push_back(thread(run, k));
+   run(0);
+   for (size_t k = 0; k < workers.size(); ++k)
+      workers[k].join();
+}
+
+#endif // MY_THREAD_H